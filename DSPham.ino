@@ -25,6 +25,24 @@
 #include "tf3lj_dec.h"
 #include "dynamicFilters.h"
 #include "dspfilter.h"
+#include "filterCache.h"
+#include "filterFade.h"
+#include "iirFilter.h"
+#include "firFloat.h"
+#include "cpuStats.h"
+#include "ioStage.h"
+#include "agc.h"
+#include "governor.h"
+#include "analysers.h"
+#include "spectrum.h"
+#include "tuning.h"
+#include "pitchTrack.h"
+#include "envelope.h"
+#include "textSink.h"
+#include "skimmer.h"
+#include "ensemble.h"
+#include "morseHmm.h"
+#include "morseBench.h"
 
 #include "settings.h"
 
@@ -45,25 +63,19 @@ AudioRecordQueue Q_in_L; // We only need one channel - we are working with mono
 AudioPlayQueue Q_out_R;
 //AudioPlayQueue Q_out_L;
 
-AudioAnalyzePeak input_peak_detector, output_peak_detector, postfir_peak_detector;
-
-//RMS detection seems to work OK for auto output level matching, but
-// then we don't get 'peak-o-meter' to show input levels...
-//AudioAnalyzeRMS input_peak_detector, output_peak_detector;
-AudioAmplifier peak_amp;
+//Input level, RMS and clipping are measured as we read the data in, and the
+// output gain and output peak are done as we write it out - see ioStage.cpp
 
 // Tone detector for morse decoding
 AudioAnalyzeToneDetect toneDetect;
-// And a note freq analyser to try and help narrow in on the signal...
-AudioAnalyzeNoteFrequency noteFreq;
 
-AudioFilterFIR firfilter;
-AudioMixer4 input_mixer;
+// Or our own envelope detector - see envelope.h
+static struct envelope key_envelope;
 
-// Go with 256fft, as it can go 'faster' than fft1024, which limits us to
-// they say 20wpm, which is no use ;-)
-//For lofturj TF3LJ baysian morse decoder
-AudioAnalyzeFFT256 morse_fft;
+// Two FIR filters, so we can load new coefficients into the idle one and
+// fade across to it - see filterFade.cpp
+AudioFilterFIR firfilter, firfilter_b;
+AudioMixer4 input_mixer, fir_mixer;
 
 //For now just Mono inputs - later we may move to stereo, in which case we either
 // set up parallel processing pipelines, or we mix here down to mono, but we'll have
@@ -71,21 +83,15 @@ AudioAnalyzeFFT256 morse_fft;
 AudioConnection          patchCord1(usb1, 0, input_mixer, 0);
 AudioConnection          patchCord2(i2s_in, 0, input_mixer, 2);
 AudioConnection          patchCord3(input_mixer, 0, firfilter, 0);
-AudioConnection          patchCord4(firfilter, 0, Q_in_L, 0);
-//gap - fill me or re-number sometime
-AudioConnection          patchCord6(Q_out_R, 0, peak_amp, 0);
-AudioConnection          patchCord7(peak_amp, 0, i2s_out, 0);
-AudioConnection          patchCord8(peak_amp, 0, i2s_out, 1);
-//Wire up the peak detectors
-AudioConnection          patchCord9(input_mixer, 0, input_peak_detector, 0);
-AudioConnection          patchCord10(firfilter, 0, postfir_peak_detector, 0);
-AudioConnection          patchCord11(peak_amp, 0, output_peak_detector, 0);
-AudioConnection          patchCord12(Q_out_R, 0, toneDetect, 0);  //Should we do these after the peak amp?
-AudioConnection          patchCord13(Q_out_R, 0, noteFreq, 0);    //Should we do these after the peak amp?
-
-//The FFT might be expensive, and we may not be using it - we should probably put an 'amp switch' before it and
-// turn it off when not in use.
-AudioConnection          patchCord14(Q_out_R, 0, morse_fft, 0);    //Should we do these after the peak amp?
+AudioConnection          patchCord4(firfilter, 0, fir_mixer, 0);
+AudioConnection          patchCord5(input_mixer, 0, firfilter_b, 0);
+AudioConnection          patchCord15(firfilter_b, 0, fir_mixer, 1);
+AudioConnection          patchCord16(fir_mixer, 0, Q_in_L, 0);
+AudioConnection          patchCord7(Q_out_R, 0, i2s_out, 0);
+AudioConnection          patchCord8(Q_out_R, 0, i2s_out, 1);
+//The output gain is already applied by the time the data hits Q_out_R
+//The analysers are only connected while something is reading them - see analysers.cpp
+AudioConnection          patchCord12(Q_out_R, 0, toneDetect, 0);
 
 AudioControlSGTL5000     sgtl5000_1;
 
@@ -99,22 +105,22 @@ const float32_t n_fpass = n_desired_BW / n_samplerate;
 const uint16_t n_dec_taps = 1 + (uint16_t) (n_att / (22.0 * (n_fstop - n_fpass)));
 // interpolate taps must be divisible by decimation factor - so round up.
 const uint16_t n_int_taps = ((uint16_t)((n_dec_taps + DF) / DF)) * (uint16_t)DF;
-const uint16_t n_int_states = (AUDIO_BLOCK_SAMPLES * N_BLOCKS) + (n_int_taps / DF) -1;
 
 arm_fir_decimate_instance_f32 FIR_dec;
 float32_t FIR_dec_coeffs[(uint16_t)n_dec_taps];
 float32_t FIR_dec_state [(int)(n_dec_taps + AUDIO_BLOCK_SAMPLES * N_BLOCKS - 1)];
 
+//The interpolator itself lives in the output stage - see ioStage.cpp
 float32_t FIR_int_coeffs[n_int_taps];
-arm_fir_interpolate_instance_f32 FIR_int;
-float32_t FIR_int_state [n_int_states];
 
 // How much gain to apply to try and match the output 'volume' to the original
 // input volume.
 float32_t peak_gain = 1.0;
 float32_t input_peak = 1.0, output_peak = 1.0, postfir_peak = 1.0;   //Default start as the same
+float32_t input_rms = 0;
 float32_t input_peak_acc = 0;
 bool input_peak_clipped = false;
+uint32_t input_clip_count = 0;    //Clipped input samples in the last period
 
 float32_t peak_ratio;
 unsigned long peak_ticktime;
@@ -129,6 +135,8 @@ unsigned long display_update_deadline = 0;
 unsigned long tone_update_deadline = 0;
 #define TONE_UPDATE_MS 250
 
+static void decoder_key(int mode, bool down, unsigned long now);
+
 void setup() {
 #if DEBUG
   Serial.begin(115200);
@@ -140,6 +148,8 @@ void setup() {
   Init_LMS_NR();
   nr_kim_init();
   xanr_init();
+  fnrFilter_init(&fnr_state);
+  fnrFilter_n_Average_init(&fnra_state);
   AudioMemory(64);    //Lots - we have RAM to spare..
   input_mixer.gain(0, 1.0);
   input_mixer.gain(2, 1.0);
@@ -148,17 +158,24 @@ void setup() {
   sgtl5000_1.lineInLevel(7);  //0.94v p-p
   sgtl5000_1.lineOutLevel(31);  //1.16v p-p
 
-  noteFreq.begin(0.15);
   lcd_setup();
   load_colour();    //load lcd screen colour.
   morseInit();
+  morseReset();
   k4icy_setup();
-  morse_fft.windowFunction(AudioWindowBlackmanNuttall256);
-  morse_fft.averageTogether(FFTAVERAGE); // Average for spike/noise canceling - does nothing with FFT1024
   tf3lj_init();
   tf3lj_dec_init();
+  hmm_init();
+  analyser_register(ANALYSER_TONE, "tone", &toneDetect, &patchCord12);
+  spectrum_init(SAMPLE_RATE / DF);
+  tuning_init(SAMPLE_RATE / DF);
+  envelope_init(&key_envelope, SAMPLE_RATE / DF);
+  skimmer_init(SAMPLE_RATE / DF);
   menu_setup();
 
+  //Generate all the preset filters up front, so selecting them later is instant
+  filter_fade_init();
+  filter_cache_init();
   current_filter_mode = 0;
   updateFilter();
 
@@ -175,16 +192,71 @@ void setup() {
   }
 
   calc_FIR_coeffs (FIR_int_coeffs, n_int_taps, (float32_t)(n_desired_BW * 1000.0), n_att, 0, 0.0, SAMPLE_RATE);
-  if (arm_fir_interpolate_init_f32(&FIR_int, (uint8_t)DF, n_int_taps, FIR_int_coeffs, FIR_int_state, AUDIO_BLOCK_SAMPLES * N_BLOCKS / (uint32_t)DF))
+  if (!io_output_init(FIR_int_coeffs, n_int_taps, DF))
   {
     Serial.print("INT coeff fail");
     while(1);
   }
 
+  agc_init(SAMPLE_RATE / DF);
+
+#if DEBUG
+  iir_filter_benchmark();
+  fir_float_benchmark();
+  morse_benchmark(decoder_key, SAMPLE_RATE / DF);
+#endif
+
   Q_in_L.begin();
   peak_ticktime = millis();   //wait one period before starting to do peak analysis
 }
 
+//Hand a key state, timed in ms, to one decoder
+static void decoder_key(int mode, bool down, unsigned long now) {
+  if (mode == DECODER_MORSE_TF3LJ) {
+    tf3lj_key(down, now);
+    sig_incount = sig_lastrx;
+    cur_time = sig_timer;
+    CW_Decode();
+    return;
+  }
+
+  if (mode == DECODER_MORSE_HMM) {
+    morseLed(down);
+    hmm_key(down, now);
+    return;
+  }
+
+  if (down) {
+    //Key is down!
+    morseLed(true);
+    if (mode == DECODER_MORSE ) morseKeyDown(now);
+    if (mode == DECODER_MORSE_K4ICY ) k4icy_keyDown(now);
+  } else {
+    //key up!
+    morseLed(false);
+    if (mode == DECODER_MORSE) morseKeyUp(now);
+    if (mode == DECODER_MORSE_K4ICY) k4icy_keyUp(now);
+  }
+}
+
+//... to whichever decoder is running, or to all of them in ensemble mode
+static void decode_key(bool down, unsigned long now) {
+  if (decoder_mode != DECODER_ENSEMBLE) {
+    decoder_key(decoder_mode, down, now);
+    return;
+  }
+
+  ensemble_begin(ENSEMBLE_WB7FHC);
+  decoder_key(DECODER_MORSE, down, now);
+  ensemble_begin(ENSEMBLE_K4ICY);
+  decoder_key(DECODER_MORSE_K4ICY, down, now);
+  ensemble_begin(ENSEMBLE_TF3LJ);
+  decoder_key(DECODER_MORSE_TF3LJ, down, now);
+  ensemble_end();
+
+  ensemble_key(down, now);
+}
+
 void loop() {
   int16_t *inp;
   int16_t *outp;
@@ -192,6 +264,7 @@ void loop() {
   static long enc1_change = 0;
   static long enc1_change_time = 0;
   unsigned long ms;
+  uint32_t cycles;
   static bool in_menu = false; //Track history to find mode transition
   static float oldvol = 0;
 
@@ -205,6 +278,7 @@ void loop() {
   unsigned long ready_micros = 0;
   static unsigned long finished_micros = 0;
   static float32_t pc_used;
+  static float32_t postfir_peak_frame = 0.0;
 
   // Do we have any volume setting from USB? If not, use our
   // menu global setting.
@@ -239,29 +313,57 @@ void loop() {
   {
     //Note when enough data became ready
     ready_micros = micros();
+    cycles = ARM_DWT_CYCCNT;
 
     for (unsigned i = 0; i < N_BLOCKS; i++)
     {
-      q15_t max_value;
-      uint32_t max_index;
       // We only process mono audio at the moment, even if the i2s is running in stereo mode..
       inp = Q_in_L.readBuffer();
-      arm_max_q15(inp, AUDIO_BLOCK_SAMPLES, &max_value, &max_index);
-
-      arm_q15_to_float (inp, &float_buffer_L[i * AUDIO_BLOCK_SAMPLES], AUDIO_BLOCK_SAMPLES); // convert int_buffer to float 32bit
+      // convert int_buffer to float 32bit, and note the peak, RMS and clipping as we go
+      io_input_block(inp, &float_buffer_L[i * AUDIO_BLOCK_SAMPLES], AUDIO_BLOCK_SAMPLES);
       Q_in_L.freeBuffer();
     }
 
     //Decimate the data down before we process
-    // in-place does not seem to work for us?, so decimate into R, and copy back to L
-    arm_fir_decimate_f32(&FIR_dec, float_buffer_L, float_buffer_R, AUDIO_BLOCK_SAMPLES * N_BLOCKS);
-    memcpy(float_buffer_L, float_buffer_R, sizeof(float32_t) * BUFFER_SIZE * N_BLOCKS / (uint32_t)(DF));
-    
+    if (fir_float_active()) {
+      // User bandpass L->R, at the full rate, then decimate back into L
+      uint32_t fir_cycles = ARM_DWT_CYCCNT;
+      fir_float_process(float_buffer_L, float_buffer_R, AUDIO_BLOCK_SAMPLES * N_BLOCKS);
+      fir_cycles = ARM_DWT_CYCCNT - fir_cycles;
+      cpu_stats_add(CPU_STAGE_FILTER, fir_cycles);
+      cycles += fir_cycles;   //Do not count it twice
+      arm_fir_decimate_f32(&FIR_dec, float_buffer_R, float_buffer_L, AUDIO_BLOCK_SAMPLES * N_BLOCKS);
+    } else {
+      // in-place does not seem to work for us?, so decimate into R, and copy back to L
+      arm_fir_decimate_f32(&FIR_dec, float_buffer_L, float_buffer_R, AUDIO_BLOCK_SAMPLES * N_BLOCKS);
+      memcpy(float_buffer_L, float_buffer_R, sizeof(float32_t) * BUFFER_SIZE * N_BLOCKS / (uint32_t)(DF));
+    }
+    cpu_stats_add(CPU_STAGE_INPUT, ARM_DWT_CYCCNT - cycles);
+
+    //If the user filter is an IIR, it runs here, at the decimated rate
+    cycles = ARM_DWT_CYCCNT;
+    iir_filter_process(float_buffer_L, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF);
+    {
+      //Only a quarter of the samples here, after decimation
+      float32_t peak;
+      uint32_t index;
+      arm_absmax_f32(float_buffer_L, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF, &peak, &index);
+      if (peak > postfir_peak_frame) postfir_peak_frame = peak;
+    }
+    cpu_stats_add(CPU_STAGE_FILTER, ARM_DWT_CYCCNT - cycles);
+
+    cycles = ARM_DWT_CYCCNT;
     if (nr_mode != NR_MODE_COMPLETE_BYPASS ) {
+      //If we are short of CPU the governor may have us run something lighter
+      int nr_run = governor_nr_mode(nr_mode);
+
       if (nb_enabled ) {
         float32_t *Energy = 0;
         
-        alt_noise_blanking(float_buffer_L, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF, Energy);
+        if (governor_nb_gate())
+          nb_gate(float_buffer_L, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF);
+        else
+          alt_noise_blanking(float_buffer_L, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF, Energy);
         memcpy(float_buffer_R, float_buffer_L, sizeof(float32_t) * BUFFER_SIZE * N_BLOCKS / (uint32_t)(DF));
       }
   
@@ -273,52 +375,48 @@ void loop() {
         //arm_copy_f32(float_buffer_R, float_buffer_L, FFT_length / 2);
       }
   
+      // Take the shared spectrum here - unless the spectral NR is going to hand us its own
+      if (nr_run != NR_MODE_SPECTRAL)
+        spectrum_process(float_buffer_L, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF);
+
       // No processing - straight copy over.
-      if (nr_mode == NR_MODE_OFF )
+      if (nr_run == NR_MODE_OFF )
       {
         memcpy(float_buffer_R, float_buffer_L, sizeof(float32_t) * BUFFER_SIZE * N_BLOCKS / (uint32_t)(DF));
       }
   
-      if (nr_mode == NR_MODE_KIM )
+      if (nr_run == NR_MODE_KIM )
       {
         // Kim code reads in from L buffer. Leaves result in both L and R buffers.
         nr_kim();
       }
   
-      if (nr_mode == NR_MODE_LMS )
+      if (nr_run == NR_MODE_LMS )
       {
         LMS_NoiseReduction(AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF, float_buffer_L);
         // And copy results out to play
         memcpy(float_buffer_R, float_buffer_L, sizeof(float32_t) * BUFFER_SIZE * N_BLOCKS / (uint32_t)(DF));
       }
   
-      if (nr_mode == NR_MODE_FNR )
+      if (nr_run == NR_MODE_FNR )
       {
-        for( int i=0; i<AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF; i++ )
-        {
-          float32_t v;
-          v = fnrFilter_n(float_buffer_L[i], fnr_level);
-          float_buffer_R[i] = v;
-        }
+        //Reads from L, puts result in R
+        fnrFilter_n(&fnr_state, float_buffer_L, float_buffer_R, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF, fnr_level);
       }
   
-      if (nr_mode == NR_MODE_FNRA )
+      if (nr_run == NR_MODE_FNRA )
       {
-        for( int i=0; i<AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF; i++ )
-        {
-          float32_t v;
-          v = fnrFilter_n_Average(float_buffer_L[i], fnra_level);
-          float_buffer_R[i] = v;
-        }
+        //Reads from L, puts result in R
+        fnrFilter_n_Average(&fnra_state, float_buffer_L, float_buffer_R, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF, fnra_level);
       }
   
-      if (nr_mode == NR_MODE_SPECTRAL )
+      if (nr_run == NR_MODE_SPECTRAL )
       {
         // Reads input from L, leaves output in R and L
         spectral_noise_reduction();
       }
   
-      if (nr_mode == NR_MODE_LLMS )
+      if (nr_run == NR_MODE_LLMS )
       {
         //Reads from L, puts result in R
         xanr(false);
@@ -329,15 +427,16 @@ void loop() {
       // Just copy over then.
       // Ideally we would not even do the float convert in full bypass mode... but, we don't currently keep
       // the non-float data around for that.
+      spectrum_process(float_buffer_L, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF);
       memcpy(float_buffer_R, float_buffer_L, sizeof(float32_t) * BUFFER_SIZE * N_BLOCKS / (uint32_t)(DF));
     }
+    cpu_stats_add(CPU_STAGE_NR, ARM_DWT_CYCCNT - cycles);
 
-    //Interpolate the data back up before we play
-    // R->L
-    arm_fir_interpolate_f32(&FIR_int, float_buffer_R, float_buffer_L, (AUDIO_BLOCK_SAMPLES * N_BLOCKS) / (uint32_t)(DF));
-    //And scale back up after interpolation. Hmm, should we be able to do this scale in the FIR filter itself ?
-    //** L -> upscale after decimate -> R **/
-    arm_scale_f32(float_buffer_L, DF, float_buffer_R, AUDIO_BLOCK_SAMPLES * N_BLOCKS);
+    if( (agc_mode == AGC_MODE_SW) && (nr_mode != NR_MODE_COMPLETE_BYPASS) ) {
+      cycles = ARM_DWT_CYCCNT;
+      agc_process(float_buffer_R, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF);
+      cpu_stats_add(CPU_STAGE_AGC, ARM_DWT_CYCCNT - cycles);
+    }
 
     for (int i = 0; i < N_BLOCKS; i++)
     {
@@ -347,8 +446,11 @@ void loop() {
         delay(1);
         outp = Q_out_R.getBuffer();
       }
-      // Finally back to 16bit samples...
-      arm_float_to_q15 (&float_buffer_R[AUDIO_BLOCK_SAMPLES * i], outp, AUDIO_BLOCK_SAMPLES);
+      // Interpolate back up, apply the output gain and pack to 16bit samples, straight
+      // into the play buffer. The DF gain is folded into the interpolator.
+      cycles = ARM_DWT_CYCCNT;
+      io_output_block(&float_buffer_R[AUDIO_BLOCK_SAMPLES * i / DF], outp, AUDIO_BLOCK_SAMPLES);
+      cpu_stats_add(CPU_STAGE_OUTPUT, ARM_DWT_CYCCNT - cycles);
       Q_out_R.playBuffer(); // play it !
     }
     
@@ -364,13 +466,17 @@ void loop() {
     if (ms >= peak_ticktime ) { 
       peak_ticktime = ms + PEAK_MS_UPDATE;
       
-      if( input_peak_detector.available() ) {
-        input_peak = input_peak_detector.read();
+      struct io_input_stats in_stats;
+
+      if( io_input_read(&in_stats) ) {
+        input_peak = in_stats.peak;
+        input_rms = in_stats.rms;
+        input_clip_count = in_stats.clips;
         // Take a rolling average of the input peak for the 'peak' display.
         input_peak_acc = (input_peak_acc * 0.9) + input_peak;
 
         //Did we clip the input?
-        if (input_peak >= 1.0 ) {
+        if (in_stats.clips > 0 ) {
           //Set the clip flag, and set the timout to clear that flag
           input_peak_clipped = true;
           peak_clipped_timer = ms + PEAK_MS_CLIPPED_CLEAR;
@@ -381,11 +487,13 @@ void loop() {
         }
       }
 
-      if( output_peak_detector.available() )
-        output_peak = output_peak_detector.read();
+      struct io_output_stats out_stats;
+
+      if( io_output_read(&out_stats) )
+        output_peak = out_stats.peak;
 
-      if( postfir_peak_detector.available() )
-        postfir_peak = postfir_peak_detector.read();
+      postfir_peak = postfir_peak_frame;
+      postfir_peak_frame = 0.0;
 
       //Enable if you need - but we evaluate often, so this generates a lot of output.
       // You might want to increase the evaluation timeout if you are debugging, and re-enable this print.
@@ -414,23 +522,48 @@ void loop() {
         if (peak_gain > 5.0) peak_gain = 5.0;
         if (peak_gain < 0.2) peak_gain = 0.2;
         
-        // And adjust the output amp stage.
-        peak_amp.gain(peak_gain);
+        // And adjust the output gain. The output stage ramps over to it.
+        io_output_gain(peak_gain);
       } else {
-        // If we are not in peak track mode, ensure we set the peak gain amp to neutral passthrough
-        peak_amp.gain(1.0);
+        // If we are not in peak track mode, ensure we set the output gain to neutral passthrough
+        io_output_gain(1.0);
       }
     }
 
-    //You can read toneDetect as a bool entitiy
-    if ( (decoder_mode == DECODER_MORSE) || (decoder_mode == DECODER_MORSE_K4ICY) || (decoder_mode == DECODER_MORSE_TF3LJ) ) {
+    bool decoding = !governor_decode_suspended() &&
+      ((decoder_mode == DECODER_MORSE) || (decoder_mode == DECODER_MORSE_K4ICY) || (decoder_mode == DECODER_MORSE_TF3LJ) ||
+       (decoder_mode == DECODER_ENSEMBLE) || (decoder_mode == DECODER_MORSE_HMM));
+
+    bool legacy = decoding && (key_source == KEY_SOURCE_LEGACY);
+    static bool enveloping = false;
+
+    //Only feed the analysers, and make the spectrum, if the current decoder reads them
+    analyser_subscribe(ANALYSER_TONE, ANALYSER_SUB_DECODER, legacy && (decoder_mode != DECODER_MORSE_TF3LJ));
+    analysers_service();
+    spectrum_subscribe(SPECTRUM_SUB_TF3LJ, legacy && (decoder_mode == DECODER_MORSE_TF3LJ));
+
+    cycles = ARM_DWT_CYCCNT;
+    if (decoding) {
+      // Zoom in around the pitch on what we are playing out, for the tuning aid
+      tuning_process(float_buffer_R, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF);
+      pitch_track_frame(pitch_track);
+
+      if (!legacy) {
+        //Starting afresh - line the envelope clock up with the one the decoders had
+        if (!enveloping) envelope_reset(&key_envelope);
+        envelope_process(&key_envelope, float_buffer_R, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF, pitch_track_freq());
+      }
+      enveloping = !legacy;
+
       if (ms >= tone_update_deadline ) { 
         char buf[64];
         tone_update_deadline = ms + TONE_UPDATE_MS;
 
-        if (noteFreq.available()) {
-          float32_t freq = noteFreq.read();
-          int freqdiff = (int)freq - morse_frequency;
+        struct tuning_estimate te;
+
+        // If we are tracking the pitch the status line shows the lock state instead
+        if ((pitch_track_state() == PITCH_OFF) && tuning_read(&te) && (te.confidence >= TUNING_MIN_CONFIDENCE)) {
+          int freqdiff = (int)te.freq - morse_frequency;
 
           //Accessing lcd.createChar() changes the internal address counter (AC) of the
           //lcd module, which then changes the cursor position (if active), which can mess
@@ -463,11 +596,20 @@ void loop() {
         }
       }
 
-      if (decoder_mode == DECODER_MORSE_TF3LJ ) {
-        if( morse_fft.available() ) {
-          tf3lj_process();  // Process the fft data
-          //Graham - FIXME - these counters are probably wrong as we are not doing an
-          // interrupt driven fft process...
+      if (!legacy) {
+        struct key_edge e;
+
+        //Every edge as it happened, then where we are now, so the decoders
+        // can time out characters and words.
+        while (envelope_pop(&key_envelope, &e)) decode_key(e.key, envelope_ms(&key_envelope, e.timestamp));
+        decode_key(envelope_key(&key_envelope), envelope_ms(&key_envelope, envelope_now(&key_envelope)));
+      } else if (decoder_mode == DECODER_MORSE_TF3LJ ) {
+        static uint32_t tf3lj_seen = 0;
+        const struct spectrum *s;
+
+        // Every spectrum since last time - there are a couple per frame
+        while ((s = spectrum_next(&tf3lj_seen)) != NULL) {
+          tf3lj_process(s);  // Process the fft data
           sig_incount = sig_lastrx;
           cur_time = sig_timer;
           CW_Decode();      // And then process any generated morse data
@@ -478,20 +620,26 @@ void loop() {
         //k4icy decoder at least stopped decoding when I did this - so, let's
         // leave it as is - and send the key state per 'cycle', even if it has
         // not changed, and presume the decoders can handle this!
-        if( toneDetect ){
-          //Key is down!
-          morseLed(true);
-          if (decoder_mode == DECODER_MORSE ) morseKeyDown();
-          if (decoder_mode == DECODER_MORSE_K4ICY ) k4icy_keyDown();
-        } else {
-          //key up!
-          morseLed(false);
-          if (decoder_mode == DECODER_MORSE) morseKeyUp();
-          if (decoder_mode == DECODER_MORSE_K4ICY) k4icy_keyUp();
-        }
+        //You can read toneDetect as a bool entitiy
+        decode_key(toneDetect, millis());
       }
+
+      //Vote on whatever is left once it goes quiet
+      ensemble_frame(decoder_mode == DECODER_ENSEMBLE,
+        legacy ? millis() : envelope_ms(&key_envelope, envelope_now(&key_envelope)));
+    } else {
+      //Nothing decoding, so nothing to track
+      pitch_track_frame(false);
+      ensemble_frame(false, millis());
+      enveloping = false;
     }
 
+    //Or every signal at once
+    skimmer_process(float_buffer_R, AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF,
+      !governor_decode_suspended() && (decoder_mode == DECODER_SKIMMER));
+    cpu_stats_add(CPU_STAGE_DECODE, ARM_DWT_CYCCNT - cycles);
+    cpu_stats_frame();
+
     //Always calculate the CPU usage - otherwise we 'wrap' and the calc goes wrong.
     {
       // Ignoring the potential timer wrapping... about every 70 minutes?
@@ -499,8 +647,18 @@ void loop() {
       unsigned long micros_used = finished_micros - ready_micros;
       pc_used = ((float32_t)micros_used / (float32_t)micros_total) * 100.0;
     }
+
+    //And let the governor know how long the whole frame took us, decoders and all
+    governor_frame(micros() - ready_micros);
   } // end of processing an audio block set
 
+  //Move any filter fade along, and if the menu or a settings load asked for a
+  // new filter, load it now, while we wait for the next set of audio blocks.
+  if (Q_in_L.available() < N_BLOCKS) filter_cache_service();
+
+  //Likewise put any decoded text out to the LCD and USB
+  if (Q_in_L.available() < N_BLOCKS) text_sink_service(ms, display);
+
   if (display) {
     int enc_change;
     static unsigned long last_change = 0;
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Software AGC - see agc.h
+//
+// The limiter is a running minimum of the wanted gain over the lookahead
+// window, followed by a running average over the same window. Every value
+// that goes into the average has seen the sample now leaving the delay
+// line, so the averaged gain can never be above what that sample needs -
+// and the average gives us a smooth ramp into it.
+
+#include <Audio.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "agc.h"
+
+#define AGC_WINDOW (AGC_LOOKAHEAD + 1)
+
+static float32_t delay_line[AGC_LOOKAHEAD];
+static float32_t want_ring[AGC_WINDOW];
+static float32_t min_ring[AGC_WINDOW];
+static float32_t min_sum;
+static int delay_pos, ring_pos;
+
+static float32_t envelope;
+static uint32_t hold_count, hold_samples;
+static float32_t attack_coef, decay_coef;
+
+static float32_t gain_buf[AGC_MAX_BLOCK];
+static float32_t delayed_buf[AGC_MAX_BLOCK];
+
+void agc_init(float32_t samplerate) {
+  attack_coef = 1.0 - expf(-1000.0 / (AGC_ATTACK_MS * samplerate));
+  decay_coef = expf(-1000.0 / (AGC_DECAY_MS * samplerate));
+  hold_samples = (uint32_t)(AGC_HOLD_MS * samplerate / 1000.0);
+  agc_reset();
+}
+
+void agc_reset(void) {
+  memset(delay_line, 0, sizeof(delay_line));
+  for (int i = 0; i < AGC_WINDOW; i++) {
+    want_ring[i] = 1.0;
+    min_ring[i] = 1.0;
+  }
+  min_sum = AGC_WINDOW;
+  delay_pos = ring_pos = 0;
+
+  envelope = AGC_TARGET;
+  hold_count = 0;
+}
+
+void agc_process(float32_t *buf, uint32_t n) {
+  if (n > AGC_MAX_BLOCK) n = AGC_MAX_BLOCK;
+
+  // The running sum creeps, so start each frame from a fresh one
+  min_sum = 0.0;
+  for (int i = 0; i < AGC_WINDOW; i++) min_sum += min_ring[i];
+
+  for (uint32_t i = 0; i < n; i++) {
+    float32_t x = buf[i];
+    float32_t a = fabsf(x);
+    float32_t want, m;
+
+    // Envelope - fast up, hold, then slow down
+    if (a > envelope) {
+      envelope += (a - envelope) * attack_coef;
+      hold_count = hold_samples;
+    } else if (hold_count) {
+      hold_count--;
+    } else {
+      envelope *= decay_coef;
+    }
+
+    if (envelope * AGC_MAX_GAIN > AGC_TARGET) want = AGC_TARGET / envelope;
+    else want = AGC_MAX_GAIN;
+
+    // Limiter
+    if (a * want > AGC_CEILING) want = AGC_CEILING / a;
+
+    want_ring[ring_pos] = want;
+    m = want_ring[0];
+    for (int j = 1; j < AGC_WINDOW; j++)
+      if (want_ring[j] < m) m = want_ring[j];
+
+    min_sum += m - min_ring[ring_pos];
+    min_ring[ring_pos] = m;
+    if (++ring_pos >= AGC_WINDOW) ring_pos = 0;
+
+    gain_buf[i] = min_sum / AGC_WINDOW;
+
+    delayed_buf[i] = delay_line[delay_pos];
+    delay_line[delay_pos] = x;
+    if (++delay_pos >= AGC_LOOKAHEAD) delay_pos = 0;
+  }
+
+  arm_mult_f32(delayed_buf, gain_buf, buf, n);
+}
+
+float32_t agc_gain(void) {
+  return min_sum / AGC_WINDOW;
+}
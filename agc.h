@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Software AGC, run on the decimated float data before we interpolate back up.
+//
+// An attack/hold/decay envelope follower sets the gain needed to bring the
+// signal to AGC_TARGET, and a brickwall limiter makes sure no sample goes out
+// above AGC_CEILING. The audio is delayed by AGC_LOOKAHEAD samples, so the gain
+// can ramp down ahead of a peak, rather than having to jump when it arrives.
+//
+// The gain is worked out per sample into a buffer, and then applied to the
+// whole frame in one go.
+
+#ifndef AGC_H
+#define AGC_H
+
+#include <arm_math.h>
+
+// Level we aim for, and level we will never go over, 0 to 1.0
+#define AGC_TARGET      0.5
+#define AGC_CEILING     0.9
+
+// Most gain we will apply, so we do not lift the noise up to full scale
+#define AGC_MAX_GAIN    10.0
+
+#define AGC_ATTACK_MS   2
+#define AGC_HOLD_MS     100
+#define AGC_DECAY_MS    500
+
+// Lookahead, in decimated samples (about 3ms).
+#define AGC_LOOKAHEAD   32
+
+// Largest frame we can be handed
+#define AGC_MAX_BLOCK   256
+
+// Set up for a samplerate, and start from unity gain.
+extern void agc_init(float32_t samplerate);
+
+// Forget the envelope and the lookahead, for when we switch in.
+extern void agc_reset(void);
+
+// Run over n samples in place. The output is AGC_LOOKAHEAD samples behind.
+extern void agc_process(float32_t *buf, uint32_t n);
+
+// Gain applied to the last sample, for display.
+extern float32_t agc_gain(void);
+
+#endif
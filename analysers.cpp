@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Analyser registry - see analysers.h
+
+#include <Audio.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "analysers.h"
+
+struct analyser {
+  const char *name;
+  AudioStream *obj;
+  AudioConnection *cord;
+  uint32_t subscribers;
+  bool connected;
+  float32_t cost;       // Smoothed processorUsage() while running
+};
+
+static struct analyser analysers[ANALYSERS];
+
+void analyser_register(int id, const char *name, AudioStream *obj, AudioConnection *cord) {
+  struct analyser *a = &analysers[id];
+
+  a->name = name;
+  a->obj = obj;
+  a->cord = cord;
+  a->subscribers = 0;
+  a->cost = 0.0;
+
+  a->cord->disconnect();
+  a->connected = false;
+}
+
+void analyser_subscribe(int id, uint32_t who, bool on) {
+  struct analyser *a = &analysers[id];
+  bool want;
+
+  if (!a->cord) return;
+
+  if (on) a->subscribers |= who;
+  else a->subscribers &= ~who;
+
+  want = (a->subscribers != 0);
+  if (want == a->connected) return;
+
+  if (want) a->cord->connect();
+  else a->cord->disconnect();
+  a->connected = want;
+
+  if (DEBUG) Serial.printf("Analyser %s %s, saving %.1f%%\n", a->name, want ? "on" : "off",
+    analysers_saved_percent());
+}
+
+bool analyser_running(int id) {
+  return analysers[id].connected;
+}
+
+void analysers_service(void) {
+  for (int i = 0; i < ANALYSERS; i++) {
+    struct analyser *a = &analysers[i];
+
+    if (a->connected) a->cost = (a->cost * 0.95) + (a->obj->processorUsage() * 0.05);
+  }
+}
+
+float32_t analysers_saved_percent(void) {
+  float32_t saved = 0.0;
+
+  for (int i = 0; i < ANALYSERS; i++)
+    if (analysers[i].cord && !analysers[i].connected) saved += analysers[i].cost;
+
+  return saved;
+}
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Audio library analysers, only run when someone wants them.
+//
+// The tone detector sits on the output at the full rate, and is not free.
+// The tuning aid and TF3LJ use the shared spectrum instead - see spectrum.h.
+//
+// Each analyser is registered here with the AudioConnection that feeds it.
+// Users (decoders, displays) subscribe to the analysers they read, and an
+// analyser only gets fed while it has at least one subscriber. With no input
+// the library update() returns straight away.
+
+#ifndef ANALYSERS_H
+#define ANALYSERS_H
+
+#include <Audio.h>
+
+enum analyser_id {
+  ANALYSER_TONE,      // toneDetect
+  ANALYSERS
+};
+
+// Subscribers - one bit each
+#define ANALYSER_SUB_DECODER  (1 << 0)
+
+// Register an analyser, and the connection that feeds it. It starts off
+// disconnected, until somebody subscribes.
+extern void analyser_register(int id, const char *name, AudioStream *obj, AudioConnection *cord);
+
+// Add (on) or drop (off) a subscriber. Cheap to call every frame.
+extern void analyser_subscribe(int id, uint32_t who, bool on);
+
+extern bool analyser_running(int id);
+
+// Keep track of what each analyser costs while it runs - call once a frame.
+extern void analysers_service(void);
+
+// CPU we think we are saving by not running the idle analysers,
+// as a percentage of the audio interrupt time.
+extern float32_t analysers_saved_percent(void);
+
+#endif
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+#include <Audio.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "cpuStats.h"
+
+static const char *stage_names[CPU_STAGES] = {
+  "input", "filter", "nr", "agc", "output", "decode"
+};
+
+static uint32_t stage_acc[CPU_STAGES];
+static uint32_t stage_avg[CPU_STAGES];
+static uint32_t frames = 0;
+static unsigned long report_deadline = 0;
+
+void cpu_stats_add(int stage, uint32_t cycles) {
+  stage_acc[stage] += cycles;
+}
+
+void cpu_stats_frame(void) {
+  unsigned long ms = millis();
+
+  frames++;
+  if (ms < report_deadline) return;
+  report_deadline = ms + CPU_STATS_REPORT_MS;
+
+  for (int i = 0; i < CPU_STAGES; i++) {
+    stage_avg[i] = stage_acc[i] / frames;
+    stage_acc[i] = 0;
+  }
+  frames = 0;
+
+  if (DEBUG) {
+    Serial.print("CPU cycles/frame:");
+    for (int i = 0; i < CPU_STAGES; i++)
+      Serial.printf(" %s %u (%.1f%%)", stage_names[i], (unsigned)stage_avg[i], cpu_stats_percent(i));
+    Serial.println("");
+  }
+}
+
+uint32_t cpu_stats_cycles(int stage) {
+  return stage_avg[stage];
+}
+
+float32_t cpu_stats_percent(int stage) {
+  // The time we have for a frame, in cycles
+  const float32_t frame_cycles = (float32_t)F_CPU_ACTUAL * (AUDIO_BLOCK_SAMPLES * N_BLOCKS) / SAMPLE_RATE;
+
+  return ((float32_t)stage_avg[stage] * 100.0) / frame_cycles;
+}
+
+const char *cpu_stats_name(int stage) {
+  return stage_names[stage];
+}
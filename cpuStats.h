@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Per stage CPU cycle accounting for the audio loop.
+//
+// Grab ARM_DWT_CYCCNT before a stage, and hand the difference to
+// cpu_stats_add() afterwards. Once a second we work out the average cycles
+// per frame for each stage, and print them if DEBUG is on.
+
+#ifndef CPUSTATS_H
+#define CPUSTATS_H
+
+#include <Arduino.h>
+
+enum cpu_stage {
+  CPU_STAGE_INPUT,      // Convert and decimate
+  CPU_STAGE_FILTER,     // User filter - float FIR or IIR
+  CPU_STAGE_NR,         // Noise blanker, notch and noise reduction
+  CPU_STAGE_AGC,        // Software AGC and limiter
+  CPU_STAGE_OUTPUT,     // Interpolate, scale and convert back out
+  CPU_STAGE_DECODE,     // Morse decoders
+  CPU_STAGES
+};
+
+#define CPU_STATS_REPORT_MS 1000
+
+extern void cpu_stats_add(int stage, uint32_t cycles);
+
+// Call once per processed frame, after all the stages.
+extern void cpu_stats_frame(void);
+
+// Average cycles per frame for a stage, over the last report period.
+extern uint32_t cpu_stats_cycles(int stage);
+
+// As a percentage of the time we have to process a frame.
+extern float32_t cpu_stats_percent(int stage);
+
+extern const char *cpu_stats_name(int stage);
+
+#endif
@@ -9,6 +9,7 @@
 #define FILTER_AM        3
 #define FILTER_FM        4
 #define FILTER_USER      5
+#define FILTER_CW_IIR    6
 
 // Single filter structure
 struct filter {
@@ -16,15 +17,23 @@ struct filter {
   const short int     filterType;
   double              freqLow;
   double              freqHigh;
-  const short int     window;                       // Windows included are Blackman, Hanning, and Hamming
-  const short int     coeff;
+  const short int     window;                       // Windows included are Blackman, Hanning, and Hamming, or a design method from filterDesign.h
+  const short int     coeff;                        // Taps - or the most taps allowed for a designed filter
+  const float         transition;                   // Designed filters only - transition band width in Hz
+  const float         atten;                        // Designed filters only - stopband attenuation in dB
 };
 
+// Entries in filterList, so tables sized by it (see filterCache.cpp) can be
+// checked at compile time. dynamicFilters.cpp will not build if it is wrong.
+#define FILTER_LIST_COUNT 6
+
 extern struct filter filterList[];
 
 #define NUM_FIR_FILTERS (sizeof[filterList]/sizeof[filterList[0])
+extern const unsigned int filterListCount;       // Number of entries in filterList
 
 extern unsigned int filterIndex;                 // index to currently selected filter above
 extern short   fir_active1[];                    // 1st DSP filter array holding the coefficient as 32bit (short)
+extern short   fir_active2[];                    // 2nd array, so we can load one whilst the other is playing
 
 #endif
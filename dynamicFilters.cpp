@@ -8,23 +8,37 @@
 #include "dynamicFilters.h"
 #include "dspfilter.h"
 #include "global.h"
+#include "filterDesign.h"
+#include "iirDesign.h"
 
 unsigned int filterIndex = 0;                 // index to currently selected filter above
 short   fir_active1[200];                      // 1st DSP filter array holding the coefficient as 32bit (short)
+short   fir_active2[200];                      // 2nd array, so we can load one whilst the other is playing
 
 /*
  *   Structure to hold the required filters (Add, delete or modify as required) 
  *   
  *   ID,      FilterType,   Low Freq,      Hi Freq,    Window,  FilterName  
+ *
+ *   W_REMEZ and W_KAISER filters are designed to the transition width and stopband
+ *   attenuation on the end, in as few taps as will do it. The 200 tap Hamming
+ *   filters these replaced managed about 50dB in ~700Hz.
+ *
+ *   W_BUTTERWORTH, W_CHEBYSHEV and W_ELLIPTIC are IIR filters, run after decimation.
+ *   coeff is then the filter order, and the passband has to fit below ~5kHz.
  */  
 struct filter filterList[] = {
-  {FILTER_PASSTHRU, ID_BANDPASS,   60.0,  20000.0, W_HAMMING,  NUM_COEFFICIENTS},
-  {FILTER_SSB,      ID_BANDPASS,  300.0,   2700.0, W_HAMMING,  NUM_COEFFICIENTS},
-  {FILTER_CW,       ID_BANDPASS,  450.0,    950.0, W_HAMMING,  NUM_COEFFICIENTS},
-  {FILTER_AM,       ID_BANDPASS,   50.0,  11000.0, W_HAMMING,  NUM_COEFFICIENTS},   //Xiegu G90 has 10.8Khz AM bandwidth
-  {FILTER_FM,       ID_BANDPASS,   50.0,  16000.0, W_HAMMING,  NUM_COEFFICIENTS},   //Guess at a wide FM bandwidth
+  {FILTER_PASSTHRU, ID_BANDPASS,   60.0,  20000.0, W_REMEZ,  NUM_COEFFICIENTS, 700.0, 50.0},
+  {FILTER_SSB,      ID_BANDPASS,  300.0,   2700.0, W_REMEZ,  NUM_COEFFICIENTS, 600.0, 50.0},
+  {FILTER_CW,       ID_BANDPASS,  450.0,    950.0, W_REMEZ,  NUM_COEFFICIENTS, 500.0, 50.0},
+  {FILTER_AM,       ID_BANDPASS,   50.0,  11000.0, W_REMEZ,  NUM_COEFFICIENTS, 700.0, 50.0},   //Xiegu G90 has 10.8Khz AM bandwidth
+  {FILTER_FM,       ID_BANDPASS,   50.0,  16000.0, W_REMEZ,  NUM_COEFFICIENTS, 700.0, 50.0},   //Guess at a wide FM bandwidth
+  {FILTER_CW_IIR,   ID_BANDPASS,  575.0,    825.0, W_ELLIPTIC,  8,                 0.0, 60.0},   //4 biquads, vs ~200 FIR taps
 };
 
+const unsigned int filterListCount = sizeof(filterList) / sizeof(filterList[0]);
+static_assert(sizeof(filterList) / sizeof(filterList[0]) == FILTER_LIST_COUNT, "FILTER_LIST_COUNT is out of date");
+
 
 double  fir_tmp[NUM_COEFFICIENTS];                          // Temp array used for coefficient calculations which are performed in 64bit
 
@@ -318,38 +332,33 @@ void audioFilter(short h[], const int &N, const int &TYPE, const int &WINDOW, co
 }
 
 //Additions from Graham
-// The filters come out with some attenuation - too much for my linking.
-// If we can measure the gain at the requested bandpass, then we can scale
-// the coefficients to actual 0db (neutral, no gain or attenuation) for the
-// chosen frequency, which should, ideally, be the peak of the filter.
-//
-// Gain is the root of the sum of the squares of cos and sin waves. Don't ask me for
-// the theory!!!
-float32_t getFilterGain(int16_t *coeffs, int ncoeffs, float32_t frequency, float32_t samplerate) {
-  float32_t cgain=0.0, sgain=0.0;
-  float32_t gain = 0.0;
-  float32_t f = frequency / samplerate;
-
-  if (DEBUG) Serial.printf("getFilterGain(ncoeff: %d, f:%f, rate:%f\n", ncoeffs, frequency, samplerate);
-
-  for(int i=0; i<ncoeffs; i++ ) {
-    float32_t c = cos(2.0 * M_PI * f * i);
-    float32_t s = sin(2.0 * M_PI * f * i);
-
-    cgain += (((float32_t)coeffs[i])/32768.0) * c;
-    sgain += (((float32_t)coeffs[i])/32768.0) * s;
+// As audioFilter(), but hand back the coefficients as floats, rather than
+// truncated to shorts.
+void audioFilterFloat(float32_t h[], const int &N, const int &TYPE, const int &WINDOW, const double &fc1, const double &fc2) {
+  switch (TYPE) {
+    case ID_LOWPASS:
+      wsfirLP(fir_tmp, N, WINDOW, fc1/AUDIO_SAMPLE_RATE_EXACT);
+      break;
+    case ID_HIGHPASS:
+      wsfirHP(fir_tmp, N, WINDOW, fc1/AUDIO_SAMPLE_RATE_EXACT);
+      break;
+    case ID_BANDPASS:
+      wsfirBP(fir_tmp, N, WINDOW, fc1/AUDIO_SAMPLE_RATE_EXACT, fc2/AUDIO_SAMPLE_RATE_EXACT);
+      break;
+    case ID_BANDSTOP:
+      wsfirBS(fir_tmp, N, WINDOW, fc1/AUDIO_SAMPLE_RATE_EXACT, fc2/AUDIO_SAMPLE_RATE_EXACT);
+      break;
+    default:
+      for (int i = 0; i < N; i++) fir_tmp[i] = 0.0;
+      break;
   }
 
-  gain = (cgain*cgain) + (sgain*sgain);
-
-  if (DEBUG) Serial.printf(" Gain: %fhz, %f sample: %f gain\n", frequency, samplerate, sqrt(gain));
-
-  //FIXME - we probably should limit the gain returned somewhere - possibly here.
-  return (sqrt(gain));
+  for (int i = 0; i < N; i++) h[i] = fir_tmp[i];
 }
 
-void normaliseCoeffs(int16_t *coeffs, int ncoeffs, float32_t multiplier) {
-  for( int i=0; i<ncoeffs; i++ ) {
-    coeffs[i] *= multiplier;
-  }
+// The filters come out with some attenuation - too much for my linking.
+// Once we have measured the gain (see filterResponse.cpp), scale the
+// coefficients to get to where we want to be.
+void normaliseCoeffsFloat(float32_t *coeffs, int ncoeffs, float32_t multiplier) {
+  arm_scale_f32(coeffs, multiplier, coeffs, ncoeffs);
 }
@@ -58,6 +58,7 @@ const int W_HAMMING =   3;
 
 // Function prototypes
 void audioFilter(short h[], const int &N, const int &TYPE, const int &WINDOW, const double &fc1, const double &fc2);
+void audioFilterFloat(float32_t h[], const int &N, const int &TYPE, const int &WINDOW, const double &fc1, const double &fc2);
 void bandpass(short h[], const int &N, const int &WINDOW, const double &fc1, const double &fc2);
 void wsfirLP(double h[], const int &N, const int &WINDOW, const double &fc);
 void wsfirHP(double h[], const int &N, const int &WINDOW, const double &fc);
@@ -68,8 +69,7 @@ void wBlackman(double w[], const int &N);
 void wHanning(double w[], const int &N);
 void wHamming(double w[], const int &N);
 
-// Helper functions to normalise FIR coefficients for maximum gain.
-extern float32_t getFilterGain(int16_t *coeffs, int ncoeffs, float32_t frequency, float32_t samplerate);
-extern void normaliseCoeffs(int16_t *coeffs, int ncoeffs, float32_t multiplier);
+// Helper function to normalise FIR coefficients for maximum gain.
+extern void normaliseCoeffsFloat(float32_t *coeffs, int ncoeffs, float32_t multiplier);
 
 #endif
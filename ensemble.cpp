@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Ensemble decoding - see ensemble.h
+
+#include <Arduino.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "ensemble.h"
+#include "morseGen.h"
+
+static const char *names[ENSEMBLE_DECODERS] = { "WB7FHC", "K4ICY", "TF3LJ" };
+
+// What each decoder has said in this slot
+struct slot {
+  char text[ENSEMBLE_SLOT_MAX + 1];
+  int len;
+  bool space;
+};
+
+static struct slot slots[ENSEMBLE_DECODERS];
+static bool spoken = false;       // Anybody said anything this slot?
+
+static int capturing = -1;
+static bool key = false;
+static unsigned long up_since;
+static bool running = false;
+
+static uint32_t said[ENSEMBLE_DECODERS];
+static uint32_t agreed[ENSEMBLE_DECODERS];
+static uint32_t votes;
+static float32_t confidence;
+
+static void clear_slots(void) {
+  for (int i = 0; i < ENSEMBLE_DECODERS; i++) {
+    slots[i].len = 0;
+    slots[i].space = false;
+  }
+  spoken = false;
+}
+
+float32_t ensemble_agreement(int who) {
+  return said[who] ? (float32_t)agreed[who] / said[who] : 0.0;
+}
+
+float32_t ensemble_confidence(void) {
+  return confidence;
+}
+
+static bool same(const struct slot *a, const struct slot *b) {
+  return (a->len == b->len) && (memcmp(a->text, b->text, a->len) == 0);
+}
+
+static void report(void) {
+  Serial.print("Ensemble agreement:");
+  for (int i = 0; i < ENSEMBLE_DECODERS; i++) {
+    Serial.printf(" %s %.0f%%", names[i], ensemble_agreement(i) * 100.0);
+  }
+  Serial.printf(", confidence %.0f%%\n", confidence * 100.0);
+}
+
+static void vote(void) {
+  int best = -1, best_votes = 0, spaces = 0;
+
+  for (int i = 0; i < ENSEMBLE_DECODERS; i++) {
+    if (slots[i].space) spaces++;
+    if (slots[i].len == 0) continue;
+
+    int n = 0;
+    for (int j = 0; j < ENSEMBLE_DECODERS; j++) {
+      if (same(&slots[i], &slots[j])) n++;
+    }
+
+    // On a tie, go with whoever has the better record
+    if ((n > best_votes) ||
+        ((n == best_votes) && (ensemble_agreement(i) > ensemble_agreement(best)))) {
+      best = i;
+      best_votes = n;
+    }
+  }
+
+  if (best >= 0) {
+    float32_t c = (float32_t)best_votes / ENSEMBLE_DECODERS;
+
+    for (int i = 0; i < slots[best].len; i++) morsePrint(slots[best].text[i]);
+
+    for (int i = 0; i < ENSEMBLE_DECODERS; i++) {
+      if (slots[i].len == 0) continue;
+      said[i]++;
+      if (same(&slots[i], &slots[best])) agreed[i]++;
+    }
+
+    confidence = ENSEMBLE_CONF_AVERAGE * confidence + (1.0 - ENSEMBLE_CONF_AVERAGE) * c;
+    if ((++votes % ENSEMBLE_REPORT_VOTES) == 0) report();
+  }
+
+  // A word gap, if most of them think so
+  if (spaces * 2 > ENSEMBLE_DECODERS) morsePrint(' ');
+
+  clear_slots();
+}
+
+void ensemble_frame(bool enabled, unsigned long now) {
+  if (!enabled) {
+    if (running && spoken) vote();
+    running = false;
+    return;
+  }
+
+  if (!running) {
+    for (int i = 0; i < ENSEMBLE_DECODERS; i++) said[i] = agreed[i] = 0;
+    votes = 0;
+    confidence = 0.0;
+    key = false;
+    up_since = now;
+    clear_slots();
+    running = true;
+  }
+
+  // Gone quiet - say what we have
+  if (!key && spoken && (now - up_since > ENSEMBLE_SETTLE_MS)) vote();
+}
+
+void ensemble_begin(int who) {
+  capturing = who;
+}
+
+void ensemble_end(void) {
+  capturing = -1;
+}
+
+bool ensemble_capture(char c) {
+  if (capturing < 0) return false;
+
+  struct slot *s = &slots[capturing];
+
+  if (c == ' ') {
+    s->space = true;
+  } else if (s->len < ENSEMBLE_SLOT_MAX) {
+    s->text[s->len++] = c;
+  }
+  spoken = true;
+  return true;
+}
+
+void ensemble_key(bool down, unsigned long now) {
+  if (down && !key && spoken) vote();
+  if (!down && key) up_since = now;
+  key = down;
+}
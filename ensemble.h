@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Ensemble decoding - run WB7FHC, K4ICY and TF3LJ side by side on the same
+// key states, and vote on what they say.
+//
+// While we feed a decoder we catch whatever it morsePrint()s, rather than
+// letting it go to the LCD. The decoders all print a character in the gap
+// after it, so everything said between one key down and the next is about
+// the same character - that is a slot. When the next character starts
+// (or things go quiet) we close the slot and vote: the text most of them
+// agree on goes to the LCD, and the confidence is the fraction that agreed.
+// If nobody agrees we go with the decoder that has agreed with the vote most
+// often so far.
+//
+// We also keep count of how often each decoder agrees with the vote, and
+// send that out over USB serial every so often, so you can see which one
+// does best where.
+
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <arm_math.h>
+
+enum ensemble_decoder {
+  ENSEMBLE_WB7FHC,
+  ENSEMBLE_K4ICY,
+  ENSEMBLE_TF3LJ,
+  ENSEMBLE_DECODERS
+};
+
+// Most a decoder can say in one slot - prosigns come out as a few letters
+#define ENSEMBLE_SLOT_MAX       8
+
+// Close the slot if the key has been up this long and somebody spoke
+#define ENSEMBLE_SETTLE_MS      1000
+
+// Send the agreement counts every this many votes
+#define ENSEMBLE_REPORT_VOTES   200
+
+// Weight of the old average confidence against the newest vote
+#define ENSEMBLE_CONF_AVERAGE   0.9
+
+// Once a frame. If enabled has just come on we start the counts afresh.
+extern void ensemble_frame(bool enabled, unsigned long now);
+
+// Catch what decoder who prints, until ensemble_end().
+extern void ensemble_begin(int who);
+extern void ensemble_end(void);
+
+// morsePrint() hands us every character. Returns true if we took it.
+extern bool ensemble_capture(char c);
+
+// After all the decoders have had a key state - closes the slot when the
+// next character starts.
+extern void ensemble_key(bool down, unsigned long now);
+
+// Running average confidence, 0 to 1, for the status line
+extern float32_t ensemble_confidence(void);
+
+// How often decoder who has agreed with the vote, 0 to 1
+extern float32_t ensemble_agreement(int who);
+
+#endif
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// CW envelope detector - see envelope.h
+
+#include <Arduino.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "envelope.h"
+
+// Follow coefficient for a time constant of ms
+static float32_t follow(float32_t ms, float32_t rate) {
+  return 1.0 - expf(-1000.0 / (ms * rate));
+}
+
+void envelope_init(struct envelope *e, float32_t samplerate) {
+  e->rate = samplerate;
+  e->lp_alpha = 1.0 - expf(-2.0 * PI * ENVELOPE_BW_HZ / samplerate);
+  e->attack = follow(ENVELOPE_ATTACK_MS, samplerate);
+  e->decay = follow(ENVELOPE_DECAY_MS, samplerate);
+  e->noise_follow = follow(ENVELOPE_NOISE_MS, samplerate);
+  e->noise_rise = follow(ENVELOPE_NOISE_RISE_MS, samplerate);
+  e->hold = (uint32_t)(ENVELOPE_HOLD_MS * samplerate / 1000.0 + 0.5);
+
+  e->osc_re = 1.0;
+  e->osc_im = 0.0;
+  e->now = 0;
+  e->head = e->tail = 0;
+  e->overruns = 0;
+  envelope_reset(e);
+}
+
+void envelope_reset(struct envelope *e) {
+  e->i1 = e->q1 = e->i2 = e->q2 = 0.0;
+
+  // Start the noise high and let it fall to the real floor, so we do not
+  // key down on the first thing we hear.
+  e->noise_level = 1.0;
+  e->sig_level = e->noise_level;
+  e->key = e->raw = e->pending = false;
+
+  e->base_ts = e->now;
+  e->base_ms = millis();
+
+  e->tail = e->head;
+}
+
+void envelope_seed(struct envelope *e, float32_t noise) {
+  e->noise_level = noise;
+  e->sig_level = noise;
+}
+
+static void push(struct envelope *e, bool k, uint32_t ts) {
+  uint32_t h = e->head;
+
+  if (h - e->tail >= ENVELOPE_QUEUE_SIZE) {
+    if (DEBUG && (e->overruns++ == 0)) Serial.println("Key edge queue overrun");
+    return;
+  }
+
+  e->queue[h & (ENVELOPE_QUEUE_SIZE - 1)].timestamp = ts;
+  e->queue[h & (ENVELOPE_QUEUE_SIZE - 1)].key = k;
+  __sync_synchronize();   //Entry out before the consumer can see it
+  e->head = h + 1;
+}
+
+bool envelope_pop(struct envelope *e, struct key_edge *edge) {
+  uint32_t t = e->tail;
+
+  if (t == e->head) return false;
+  __sync_synchronize();   //Do not read the entry before we saw head move
+
+  *edge = e->queue[t & (ENVELOPE_QUEUE_SIZE - 1)];
+  e->tail = t + 1;
+  return true;
+}
+
+void envelope_process(struct envelope *e, const float32_t *buf, uint32_t n, float32_t freq) {
+  float32_t step_re = arm_cos_f32(2.0 * PI * freq / e->rate);
+  float32_t step_im = arm_sin_f32(2.0 * PI * freq / e->rate);
+  // Work on locals - this is per sample, per channel
+  float32_t osc_re = e->osc_re, osc_im = e->osc_im;
+  float32_t i1 = e->i1, q1 = e->q1, i2 = e->i2, q2 = e->q2;
+  float32_t sig_level = e->sig_level, noise_level = e->noise_level;
+  const float32_t a = e->lp_alpha;
+
+  for (uint32_t k = 0; k < n; k++, e->now++) {
+    float32_t x = buf[k];
+    float32_t t;
+
+    // Mix down and low pass
+    i1 += a * (x * osc_re - i1);
+    q1 += a * (-x * osc_im - q1);
+    i2 += a * (i1 - i2);
+    q2 += a * (q1 - q2);
+
+    t = osc_re * step_re - osc_im * step_im;
+    osc_im = osc_re * step_im + osc_im * step_re;
+    osc_re = t;
+
+    // Full scale sine reads 1.0
+    float32_t env = 2.0 * sqrtf(i2 * i2 + q2 * q2);
+
+    if (env > sig_level) sig_level += e->attack * (env - sig_level);
+    else sig_level += e->decay * (env - sig_level);
+
+    // The noise follows us down at any time, but up only between elements
+    if ((env < noise_level) || !e->key) noise_level += e->noise_follow * (env - noise_level);
+    else noise_level += e->noise_rise * (env - noise_level);
+
+    if (sig_level < noise_level) sig_level = noise_level;
+
+    float32_t span = sig_level - noise_level;
+    if ((sig_level < noise_level * ENVELOPE_MIN_SNR) || (sig_level < ENVELOPE_MIN_LEVEL)) e->raw = false;
+    else if (e->raw) e->raw = env > noise_level + span * ENVELOPE_THRESH_LO;
+    else e->raw = env > noise_level + span * ENVELOPE_THRESH_HI;
+
+    // A change has to hold before we commit to it, but it is timed from
+    // when it started.
+    if (e->raw == e->key) {
+      e->pending = false;
+    } else if (!e->pending) {
+      e->pending = true;
+      e->pending_since = e->now;
+    } else if (e->now - e->pending_since >= e->hold) {
+      e->key = e->raw;
+      e->pending = false;
+      push(e, e->key, e->pending_since);
+    }
+  }
+
+  // Keep the phasor on the unit circle
+  float32_t mag = sqrtf(osc_re * osc_re + osc_im * osc_im);
+  e->osc_re = osc_re / mag;
+  e->osc_im = osc_im / mag;
+  e->i1 = i1;
+  e->q1 = q1;
+  e->i2 = i2;
+  e->q2 = q2;
+  e->sig_level = sig_level;
+  e->noise_level = noise_level;
+}
+
+bool envelope_key(const struct envelope *e) {
+  return e->key;
+}
+
+uint32_t envelope_now(const struct envelope *e) {
+  // Anything after a change that has not held yet is still in doubt
+  return e->pending ? e->pending_since : e->now;
+}
+
+uint32_t envelope_ms(const struct envelope *e, uint32_t timestamp) {
+  return e->base_ms + (uint32_t)((double)(timestamp - e->base_ts) * 1000.0 / e->rate);
+}
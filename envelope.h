@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// CW envelope detector - the key front end for the decoders.
+//
+// Rather than poll a tone detector once a frame (23ms, so a 60wpm dit gets
+// one look at most, and often none), we run the decimated audio through our
+// own detector, sample by sample. Mix the pitch down to DC, low pass I and Q
+// a little wider than the fastest dit we care about (a crude matched
+// filter), and take the magnitude. That is compared against adaptive signal
+// and noise levels, with hysteresis and a short hold to knock out glitches.
+//
+// Every key change goes into a single producer, single consumer lock free
+// queue as (state, sample timestamp), so the decoders get the edges as
+// they happened, not when we got round to looking.
+
+#ifndef ENVELOPE_H
+#define ENVELOPE_H
+
+#include <arm_math.h>
+
+// Bandwidth of each of the two I/Q low pass poles. About 50Hz overall, so a
+// 7ms rise time - fine for 60wpm and more.
+#define ENVELOPE_BW_HZ        100
+
+// How long a new state has to stick before we believe it
+#define ENVELOPE_HOLD_MS      2
+
+// Signal level attack and decay, noise level follow times
+#define ENVELOPE_ATTACK_MS    1
+#define ENVELOPE_DECAY_MS     1500
+#define ENVELOPE_NOISE_MS     100
+// ... and how slowly the noise may creep up while the key is down, so a
+// rising band noise cannot hold the key down for ever.
+#define ENVELOPE_NOISE_RISE_MS 5000
+
+// Key down above this fraction of the way from noise to signal, up below
+// the lower one.
+#define ENVELOPE_THRESH_HI    0.5
+#define ENVELOPE_THRESH_LO    0.3
+
+// Signal must be this many times the noise (amplitude) for any key down
+#define ENVELOPE_MIN_SNR      3.0
+// ... and not lost in the bottom bits (-80dBFS)
+#define ENVELOPE_MIN_LEVEL    0.0001
+
+// Edges we can hold - a power of two. A frame is 23ms, so this is plenty.
+#define ENVELOPE_QUEUE_SIZE   64
+
+struct key_edge {
+  uint32_t timestamp;     // Decimated samples
+  bool key;               // true for key down
+};
+
+// One detector. The skimmer runs one of these per channel, so everything
+// lives in here rather than in file statics.
+struct envelope {
+  float32_t rate;
+
+  // Coefficients, worked out from the rate
+  float32_t lp_alpha;
+  float32_t attack, decay, noise_follow, noise_rise;
+  uint32_t hold;                  // samples
+
+  // Local oscillator, as a rotating phasor
+  float32_t osc_re, osc_im;
+
+  // Two cascaded one pole low passes on each of I and Q
+  float32_t i1, q1, i2, q2;
+
+  float32_t sig_level, noise_level;
+
+  uint32_t now;                   // samples we have seen
+  bool key;                       // State we have committed to
+  bool raw;                       // Comparator, before the hold
+  bool pending;
+  uint32_t pending_since;
+
+  // Where envelope_ms() counts from
+  uint32_t base_ts;
+  unsigned long base_ms;
+
+  // The queue. The detector is the only writer of head, the consumer the
+  // only writer of tail.
+  struct key_edge queue[ENVELOPE_QUEUE_SIZE];
+  volatile uint32_t head, tail;
+  uint32_t overruns;
+};
+
+extern void envelope_init(struct envelope *e, float32_t samplerate);
+
+// We are (re)starting - flush the queue and line the clock up with millis()
+extern void envelope_reset(struct envelope *e);
+
+// n decimated samples of what we play out, with the CW pitch in Hz
+extern void envelope_process(struct envelope *e, const float32_t *buf, uint32_t n, float32_t freq);
+
+// We already know roughly what the noise is (from a spectrum, say), so
+// start from there rather than waiting for our own estimate to settle.
+extern void envelope_seed(struct envelope *e, float32_t noise);
+
+// Take the oldest edge off the queue. false if there are none.
+extern bool envelope_pop(struct envelope *e, struct key_edge *edge);
+
+// Key state we are sure of, and up to what time we are sure of it
+extern bool envelope_key(const struct envelope *e);
+extern uint32_t envelope_now(const struct envelope *e);
+
+// Turn an edge timestamp into milliseconds on the same footing as millis(),
+// which is what the decoders time with.
+extern uint32_t envelope_ms(const struct envelope *e, uint32_t timestamp);
+
+#endif
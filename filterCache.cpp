@@ -0,0 +1,286 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+#include <Audio.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "dynamicFilters.h"
+#include "dspfilter.h"
+#include "filterDesign.h"
+#include "iirDesign.h"
+#include "iirFilter.h"
+#include "firFloat.h"
+#include "filterResponse.h"
+#include "filterCache.h"
+#include "filterFade.h"
+
+#define FILTER_CACHE_PRESET_SLOTS 8   //Must be at least as many as entries in filterList
+#define FILTER_CACHE_SLOTS (FILTER_CACHE_PRESET_SLOTS + FILTER_CACHE_USER_SLOTS)
+
+static_assert(FILTER_LIST_COUNT <= FILTER_CACHE_PRESET_SLOTS, "a filterList preset has no cache slot");
+
+// Everything that goes into making a set of coefficients.
+struct filter_key {
+  double fc1;
+  double fc2;
+  short type;
+  short window;
+  short taps;
+  float transition;
+  float atten;
+};
+
+struct filter_cache_entry {
+  struct filter_key key;
+  float32_t fcoeffs[NUM_COEFFICIENTS];
+  short coeffs[NUM_COEFFICIENTS];       //The same, quantised for the AudioFilterFIR
+  short ntaps;            //Taps actually used - designed filters can use fewer than key.taps
+  uint32_t last_used;     //For LRU recycling of user slots
+  bool valid;
+};
+
+static struct filter_cache_entry cache[FILTER_CACHE_SLOTS];
+static uint32_t use_counter = 0;
+
+static struct filter_key pending_key;
+static bool pending = false;
+static unsigned long last_design_ms;
+
+// A user entry we are designing to spec a step at a time, and how far it has
+// got. Its preview is playing in the meantime, and it is not valid until done.
+static struct filter_cache_entry *designing = NULL;
+static struct filter_design design;
+
+static void make_key(const struct filter *f, struct filter_key *k) {
+  k->fc1 = f->freqLow;
+  k->fc2 = f->freqHigh;
+  k->type = f->filterType;
+  k->window = f->window;
+  k->taps = f->coeff;
+  k->transition = f->transition;
+  k->atten = f->atten;
+}
+
+static bool key_match(const struct filter_key *a, const struct filter_key *b) {
+  return (a->fc1 == b->fc1) && (a->fc2 == b->fc2) && (a->type == b->type) &&
+    (a->window == b->window) && (a->taps == b->taps) &&
+    (a->transition == b->transition) && (a->atten == b->atten);
+}
+
+// Scale the coefficients so the filter peaks at (close to) unity gain. We
+// design and scale in float, and only then quantise the q15 set, so the
+// rounding only happens the once.
+static void filter_scale(const struct filter_key *k, float32_t *fcoeffs, short *coeffs, int ntaps) {
+  struct filter_response r;
+  const float32_t maxgain = 2.0;
+  float32_t gain, multiplier;
+
+  // Measure the true peak, rather than the gain at the centre, which can be
+  // in a dip for a wide or lopsided filter.
+  filter_response_fir_f32(fcoeffs, ntaps, SAMPLE_RATE, k->fc1, k->fc2, &r);
+  gain = r.peak_gain;
+
+  if (DEBUG) filter_response_print("FIR designed", &r);
+
+  // Try limiting the max 'gain' to something 'sensible'. Well, OK, I'd like it so we never
+  // need to apply any gain to the FIR coefficients in the first place, but that is not what we seem
+  // to get from the FIR dynamic calculators.
+  if (1.0/gain > maxgain){
+    if (DEBUG) Serial.println("Clipping FIR gain");
+    multiplier = maxgain;
+  } else {
+    multiplier = 1.0/gain;
+  }
+
+  //Scale the multiplier down to 90%, so we avoid any risk of clipping
+  multiplier *= 0.9;
+
+  if (DEBUG) Serial.printf("FIR multiplier set to %f\n", multiplier);
+
+  //And scale it so we try not to be at 100% for a pure signal, to try and avoid
+  // any potential clipping (unlikely it is that we will ever end up in that situation).
+  normaliseCoeffsFloat(fcoeffs, ntaps, multiplier);
+
+  //Saturating, so a tap of exactly 1.0 does not wrap
+  arm_float_to_q15(fcoeffs, coeffs, ntaps);
+}
+
+// Window based, or a spec the designer could not make sense of
+static int filter_design_window(const struct filter_key *k, float32_t *fcoeffs) {
+  int ntaps = (k->window <= W_HAMMING) ? k->taps : NUM_COEFFICIENTS;
+
+  audioFilterFloat(fcoeffs, ntaps, k->type, (k->window <= W_HAMMING) ? k->window : W_HAMMING, k->fc1, k->fc2);
+  return ntaps;
+}
+
+// Generate the coefficients, all in one go. Returns how many taps we ended
+// up with.
+static int filter_design(const struct filter_key *k, float32_t *fcoeffs, short *coeffs) {
+  int ntaps = 0;
+
+  //Don't forget - the FIR filters happen before decimation, so are at the full sample rate...
+  if ((k->window == W_KAISER) || (k->window == W_REMEZ)) {
+    ntaps = designFilter(fcoeffs, k->taps, k->type, k->window, k->fc1, k->fc2, k->transition, k->atten, SAMPLE_RATE);
+  }
+  if (ntaps == 0) ntaps = filter_design_window(k, fcoeffs);
+
+  filter_scale(k, fcoeffs, coeffs, ntaps);
+  return ntaps;
+}
+
+// Start generating the coefficients for e, to be finished off a step at a
+// time by filter_design_service(). A designed filter could take many
+// Remez runs, so until then e gets a quick Kaiser preview. Anything else is
+// quick enough to do here and now.
+static void filter_design_start(struct filter_cache_entry *e) {
+  const struct filter_key *k = &e->key;
+  int ntaps = 0;
+
+  if ((k->window == W_KAISER) || (k->window == W_REMEZ)) {
+    ntaps = designFilterStart(&design, e->fcoeffs, k->taps, k->type, k->window, k->fc1, k->fc2,
+      k->transition, k->atten, SAMPLE_RATE);
+  }
+
+  if (ntaps) {
+    designing = e;
+  } else {
+    ntaps = filter_design_window(k, e->fcoeffs);
+    e->valid = true;
+  }
+
+  e->ntaps = ntaps;
+  filter_scale(k, e->fcoeffs, e->coeffs, ntaps);
+}
+
+static struct filter_cache_entry *cache_find(const struct filter_key *k) {
+  for (int i = 0; i < FILTER_CACHE_SLOTS; i++) {
+    if (cache[i].valid && key_match(&cache[i].key, k)) return &cache[i];
+  }
+  return NULL;
+}
+
+// Presets are pinned - only ever recycle one of the user slots.
+static struct filter_cache_entry *cache_victim(void) {
+  struct filter_cache_entry *e = &cache[FILTER_CACHE_PRESET_SLOTS];
+
+  for (int i = FILTER_CACHE_PRESET_SLOTS; i < FILTER_CACHE_SLOTS; i++) {
+    if (!cache[i].valid) return &cache[i];
+    if (cache[i].last_used < e->last_used) e = &cache[i];
+  }
+  return e;
+}
+
+static void filter_apply(struct filter_cache_entry *e) {
+  e->last_used = ++use_counter;
+
+  if (fir_path == FIR_PATH_FLOAT) {
+    fir_float_start(e->fcoeffs, e->ntaps);
+    filter_fade_start(FIR_PASSTHRU, 0);
+  } else {
+    filter_fade_start(e->coeffs, e->ntaps);
+    fir_float_stop();
+  }
+  iir_filter_stop();
+}
+
+// IIR filters are cheap to design, so are not cached. They run after
+// decimation, and the FIRs are set to pass straight through.
+// Returns false if we could not design it, and should use a FIR instead.
+static bool filter_apply_iir(const struct filter_key *k) {
+  float32_t coeffs[IIR_MAX_STAGES * 5];
+  int stages;
+
+  stages = designIIR(coeffs, k->taps, k->window, k->fc1, k->fc2, FILTER_DESIGN_RIPPLE_DB, k->atten, SAMPLE_RATE / DF);
+  if (stages == 0) return false;
+
+  if (DEBUG) {
+    struct filter_response r;
+    filter_response_iir(coeffs, stages, SAMPLE_RATE / DF, k->fc1, k->fc2, &r);
+    filter_response_print("IIR designed", &r);
+  }
+
+  iir_filter_start(coeffs, stages);
+  filter_fade_start(FIR_PASSTHRU, 0);
+  fir_float_stop();
+  return true;
+}
+
+// One step of any design in progress, and fade over to it once it is done
+static void filter_design_service(void) {
+  struct filter_cache_entry *e = designing;
+  int ntaps;
+
+  if (!e) return;
+
+  ntaps = designFilterStep(&design, e->fcoeffs);
+  if (ntaps == 0) return;
+
+  designing = NULL;
+  e->ntaps = ntaps;
+  filter_scale(&e->key, e->fcoeffs, e->coeffs, ntaps);
+  e->valid = true;
+  filter_apply(e);
+}
+
+void filter_cache_init(void) {
+  for (int i = 0; i < FILTER_CACHE_SLOTS; i++) cache[i].valid = false;
+
+  for (unsigned i = 0; i < filterListCount; i++) {
+    if (IS_IIR_WINDOW(filterList[i].window)) continue;
+    make_key(&filterList[i], &cache[i].key);
+    cache[i].ntaps = filter_design(&cache[i].key, cache[i].fcoeffs, cache[i].coeffs);
+    cache[i].last_used = 0;
+    cache[i].valid = true;
+  }
+  pending = false;
+  designing = NULL;
+  last_design_ms = millis() - FILTER_DESIGN_MIN_MS;
+}
+
+void filter_cache_request(const struct filter *f) {
+  //Any older queued request is now stale. Leave the current filter running
+  // until this one is ready to fade in.
+  make_key(f, &pending_key);
+  pending = true;
+}
+
+bool filter_cache_pending(void) {
+  return pending;
+}
+
+void filter_cache_service(void) {
+  struct filter_cache_entry *e;
+
+  filter_fade_service();
+
+  //Let any fade finish before we start the next one
+  if (filter_fade_busy() || iir_filter_busy() || fir_float_busy()) return;
+
+  if (!pending) {
+    filter_design_service();
+    return;
+  }
+
+  //Whatever we were designing is not wanted now
+  designing = NULL;
+
+  if (IS_IIR_WINDOW(pending_key.window) && filter_apply_iir(&pending_key)) {
+    pending = false;
+    return;
+  }
+
+  e = cache_find(&pending_key);
+  if (!e) {
+    //Rate limit the expensive bit, so continuous tuning has a bounded cost
+    if (millis() - last_design_ms < FILTER_DESIGN_MIN_MS) return;
+    last_design_ms = millis();
+
+    e = cache_victim();
+    e->valid = false;
+    e->key = pending_key;
+    filter_design_start(e);
+  }
+
+  pending = false;
+  filter_apply(e);
+}
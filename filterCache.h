@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Cache of generated and normalised FIR coefficients, so switching between
+// filters we have already seen does not have to re-run the filter design
+// inside the audio loop.
+
+#ifndef FILTERCACHE_H
+#define FILTERCACHE_H
+
+#include "dspfilter.h"
+
+// Extra slots, on top of one per preset, for user tweaked frequencies.
+// Least recently used gets recycled.
+#define FILTER_CACHE_USER_SLOTS 4
+
+// Generate the coefficients for all the presets in filterList. Call once
+// at boot, before filterList gets modified by settings or the menu.
+extern void filter_cache_init(void);
+
+// Don't generate new (uncached) coefficients more often than this. Whilst
+// the encoder is spinning the requests in between get coalesced, so we only
+// ever build the latest one.
+#define FILTER_DESIGN_MIN_MS 100
+
+// Ask for filter f to become the active FIR. The request is queued, and
+// filter_cache_service() fades over to it - from the cache if we have seen it
+// before, otherwise once it has been generated. A filter designed to spec
+// (W_KAISER or W_REMEZ) is generated a step per call, with a quick Kaiser
+// preview playing until it is done. Only the latest queued request is kept.
+extern void filter_cache_request(const struct filter *f);
+
+// Step any filter fade along, and load any queued filter, or take the next
+// step of designing one. Call from the main loop when we are not busy with
+// audio.
+extern void filter_cache_service(void);
+
+// True if there is a filter waiting to be loaded.
+extern bool filter_cache_pending(void);
+
+#endif
@@ -0,0 +1,499 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// FIR design to a spec - see filterDesign.h
+//
+// The Remez exchange follows the structure of Jake Janovetz's public domain
+// remez.c, cut down to the odd length, symmetric (type I) filters we need.
+// Kaiser sizing and beta are the usual Kaiser formulas, as also used for the
+// decimation filters in fir.cpp.
+
+#include <Audio.h>
+#include <arm_math.h>
+#include <math.h>
+
+#include "global.h"
+#include "dynamicFilters.h"
+#include "fir.h"
+#include "filterDesign.h"
+#include "filterResponse.h"
+
+#define REMEZ_GRID_DENSITY    16
+#define REMEZ_MAX_ITERATIONS  40
+
+#define MAX_DESIGN_TAPS NUM_COEFFICIENTS
+#define MAX_R           (MAX_DESIGN_TAPS / 2 + 1)               // Cosine terms in the biggest filter, plus one
+#define MAX_GRID        (REMEZ_GRID_DENSITY * MAX_R + 4)
+
+// Where a design has got to - see designFilterStep()
+enum {
+  STAGE_TRIAL,                // Start on a trial of d->n taps
+  STAGE_ITERATE,              // Remez exchanges
+  STAGE_FINISH,               // Remez solution to impulse response
+  STAGE_CHECK,                // Does the trial meet the spec?
+  STAGE_DONE
+};
+
+static double design_h[MAX_DESIGN_TAPS];
+static float32_t check_h[MAX_DESIGN_TAPS];
+
+// Remez working storage - static, as it is too big for the stack
+static double grid_x[MAX_GRID];             // cos(2*pi*f) of each grid point
+static float32_t grid_d[MAX_GRID];          // Desired response
+static float32_t grid_w[MAX_GRID];          // Weight
+static float32_t grid_e[MAX_GRID];          // Weighted error
+static int found_ext[MAX_GRID];
+static int ext[MAX_R + 1];
+static double ext_x[MAX_R + 1], ext_ad[MAX_R + 1], ext_y[MAX_R + 1];
+static double freq_a[MAX_R];
+static double cos_n[MAX_DESIGN_TAPS];
+
+int kaiserTapEstimate(double atten, double dF) {
+  return (int)((atten - 7.95) / (14.36 * dF)) + 1;
+}
+
+int remezTapEstimate(double ripple_db, double atten, double dF) {
+  double r = pow(10.0, ripple_db / 20.0);
+  double dp = (r - 1.0) / (r + 1.0);
+  double ds = pow(10.0, -atten / 20.0);
+
+  return (int)((-10.0 * log10(dp * ds) - 13.0) / (14.6 * dF)) + 1;
+}
+
+// Turn the request into a set of bands. Returns false if there is no room
+// for a passband and at least one stopband.
+static bool make_spec(struct filter_spec *s, int type, double fc1, double fc2, double tw, double atten, double samplerate) {
+  double r = pow(10.0, FILTER_DESIGN_RIPPLE_DB / 20.0);
+  double plo, phi;
+
+  s->dpass = (r - 1.0) / (r + 1.0);
+  s->dstop = pow(10.0, -atten / 20.0);
+
+  fc1 /= samplerate;
+  fc2 /= samplerate;
+  tw /= samplerate;
+
+  switch (type) {
+    case ID_LOWPASS:
+      plo = 0.0;
+      phi = fc1;
+      break;
+    case ID_HIGHPASS:
+      plo = fc1;
+      phi = 0.5;
+      break;
+    case ID_BANDPASS:
+      plo = fc1;
+      phi = fc2;
+      break;
+    default:
+      return false;
+  }
+
+  if ((tw <= 0.0) || (plo >= phi) || (phi > 0.5)) return false;
+
+  // If there is no room for a stopband below the passband, then we are
+  // really a lowpass - and the same for highpass above.
+  if (plo - tw <= 0.0) plo = 0.0;
+  if (phi + tw >= 0.5) phi = 0.5;
+
+  s->nbands = 0;
+  s->cutlo = 0.0;
+  s->cuthi = 0.5;
+
+  if (plo > 0.0) {
+    s->bands[s->nbands++] = { 0.0, plo - tw, 0.0, s->dpass / s->dstop };
+    s->cutlo = plo - tw / 2.0;
+  }
+  s->bands[s->nbands++] = { plo, phi, 1.0, 1.0 };
+  if (phi < 0.5) {
+    s->bands[s->nbands++] = { phi + tw, 0.5, 0.0, s->dpass / s->dstop };
+    s->cuthi = phi + tw / 2.0;
+  }
+
+  return (s->nbands > 1);
+}
+
+//---------------------------------------------------------------
+// Kaiser windowed sinc, n taps (odd)
+static void kaiser_design(const struct filter_spec *s, int n, double h[]) {
+  const int m = (n - 1) / 2;
+  double atten = -20.0 * log10(fmin(s->dpass, s->dstop));
+  double beta, izb;
+
+  if (atten < 21.0) beta = 0.0;
+  else if (atten <= 50.0) beta = 0.5842 * pow(atten - 21.0, 0.4) + 0.07886 * (atten - 21.0);
+  else beta = 0.1102 * (atten - 8.7);
+
+  izb = Izero(beta);
+
+  for (int i = 0; i < n; i++) {
+    int k = i - m;
+    double x = (double)k / (double)m;
+    double ideal;
+
+    // Difference of two ideal lowpass filters. cuthi of 0.5 is the impulse.
+    if (k == 0) {
+      ideal = 2.0 * (s->cuthi - s->cutlo);
+    } else {
+      ideal = (sin(2.0 * M_PI * s->cuthi * k) - sin(2.0 * M_PI * s->cutlo * k)) / (M_PI * k);
+    }
+
+    h[i] = ideal * Izero(beta * sqrt(1.0 - x * x)) / izb;
+  }
+}
+
+//---------------------------------------------------------------
+// Remez exchange
+
+// Lagrange interpolation coefficients, delta, and the values at the extremals.
+static void remez_params(int r) {
+  int ld = (r - 1) / 15 + 1;
+  double numer = 0.0, denom = 0.0, delta;
+  int sign = 1;
+
+  for (int i = 0; i <= r; i++) ext_x[i] = grid_x[ext[i]];
+
+  for (int i = 0; i <= r; i++) {
+    double d = 1.0;
+
+    // Multiply in strides so the product does not run out of range
+    for (int j = 0; j < ld; j++)
+      for (int k = j; k <= r; k += ld)
+        if (k != i) d *= 2.0 * (ext_x[i] - ext_x[k]);
+
+    if (fabs(d) < 0.00001) d = 0.00001;
+    ext_ad[i] = 1.0 / d;
+  }
+
+  for (int i = 0; i <= r; i++) {
+    numer += ext_ad[i] * grid_d[ext[i]];
+    denom += sign * ext_ad[i] / grid_w[ext[i]];
+    sign = -sign;
+  }
+  delta = numer / denom;
+
+  sign = 1;
+  for (int i = 0; i <= r; i++) {
+    ext_y[i] = grid_d[ext[i]] - sign * delta / grid_w[ext[i]];
+    sign = -sign;
+  }
+}
+
+// Response of the current solution at x = cos(2*pi*f)
+static double remez_response(double x, int r) {
+  double numer = 0.0, denom = 0.0;
+
+  for (int i = 0; i <= r; i++) {
+    double c = x - ext_x[i];
+
+    if (fabs(c) < 1.0e-7) return ext_y[i];
+    c = ext_ad[i] / c;
+    denom += c;
+    numer += c * ext_y[i];
+  }
+  return numer / denom;
+}
+
+// Find the new set of r+1 extremals of the error. Returns false if there are
+// not enough of them, which means we are not going to converge.
+static bool remez_search(int r, int gridsize) {
+  float32_t *e = grid_e;
+  int k = 0;
+
+  if (((e[0] > 0.0) && (e[0] > e[1])) || ((e[0] < 0.0) && (e[0] < e[1])))
+    found_ext[k++] = 0;
+
+  for (int i = 1; i < gridsize - 1; i++) {
+    if (((e[i] >= e[i-1]) && (e[i] > e[i+1]) && (e[i] > 0.0)) ||
+        ((e[i] <= e[i-1]) && (e[i] < e[i+1]) && (e[i] < 0.0)))
+      found_ext[k++] = i;
+  }
+
+  int j = gridsize - 1;
+  if (((e[j] > 0.0) && (e[j] > e[j-1])) || ((e[j] < 0.0) && (e[j] < e[j-1])))
+    found_ext[k++] = j;
+
+  if (k < r + 1) return false;
+
+  // Too many - throw away the smallest, or one of any pair that does not alternate
+  while (k > r + 1) {
+    bool up = (e[found_ext[0]] > 0.0);
+    bool alt = true;
+    int l = 0;
+
+    for (j = 1; j < k; j++) {
+      if (fabs(e[found_ext[j]]) < fabs(e[found_ext[l]])) l = j;
+      if (up && (e[found_ext[j]] < 0.0)) up = false;
+      else if (!up && (e[found_ext[j]] > 0.0)) up = true;
+      else {
+        alt = false;
+        l = (fabs(e[found_ext[j]]) < fabs(e[found_ext[j-1]])) ? j : j - 1;
+        break;
+      }
+    }
+
+    //Only one too many, and all alternating - drop whichever end is smaller
+    if (alt && (k == r + 2)) {
+      l = (fabs(e[found_ext[k-1]]) < fabs(e[found_ext[0]])) ? k - 1 : 0;
+    }
+
+    for (j = l; j < k - 1; j++) found_ext[j] = found_ext[j+1];
+    k--;
+  }
+
+  for (int i = 0; i <= r; i++) ext[i] = found_ext[i];
+  return true;
+}
+
+// Parks-McClellan, d->n taps (odd), a step at a time. Set up the dense grid
+// and the first guess at the extremals. Returns false if there are not
+// enough grid points for that many taps.
+static bool remez_start(struct filter_design *d) {
+  const struct filter_spec *s = &d->spec;
+  const int r = (d->n - 1) / 2 + 1;
+  const double delf = 0.5 / (REMEZ_GRID_DENSITY * r);
+  int gridsize = 0;
+
+  d->iter = 0;
+  d->converged = false;
+
+  // Dense grid over the bands only - the transition bands are don't care
+  for (int b = 0; b < s->nbands; b++) {
+    const struct filter_band *bp = &s->bands[b];
+    int k = (int)((bp->hi - bp->lo) / delf + 0.5);
+    double f = bp->lo;
+
+    if (k == 0) k = 1;
+    for (int i = 0; i < k; i++) {
+      grid_x[gridsize] = cos(2.0 * M_PI * f);
+      grid_d[gridsize] = bp->desired;
+      grid_w[gridsize] = bp->weight;
+      gridsize++;
+      f += delf;
+    }
+    grid_x[gridsize - 1] = cos(2.0 * M_PI * bp->hi);
+  }
+  d->gridsize = gridsize;
+
+  if (gridsize < r + 2) return false;
+
+  for (int i = 0; i <= r; i++) ext[i] = i * (gridsize - 1) / r;
+  return true;
+}
+
+// One exchange. Returns true once there are no more to do - it has
+// converged, or is not going to.
+static bool remez_iterate(struct filter_design *d) {
+  const int r = (d->n - 1) / 2 + 1;
+  float32_t emax = 0.0, emin = 1e30;
+
+  remez_params(r);
+
+  for (int i = 0; i < d->gridsize; i++)
+    grid_e[i] = grid_w[i] * (grid_d[i] - remez_response(grid_x[i], r));
+
+  if (!remez_search(r, d->gridsize)) return true;
+
+  for (int i = 0; i <= r; i++) {
+    float32_t e = fabs(grid_e[ext[i]]);
+    if (e > emax) emax = e;
+    if (e < emin) emin = e;
+  }
+
+  if ((emax - emin) / emax < 0.0001) {
+    d->converged = true;
+    return true;
+  }
+  return (++d->iter >= REMEZ_MAX_ITERATIONS);
+}
+
+// Turn the solution into n taps in design_h[]
+static void remez_finish(int n) {
+  const int m = (n - 1) / 2;
+  const int r = m + 1;
+
+  remez_params(r);
+
+  // Every cosine the inverse DFT needs is one of these
+  for (int j = 0; j < n; j++) cos_n[j] = cos(2.0 * M_PI * j / n);
+
+  // Sample the response and inverse DFT it back to the impulse response
+  for (int k = 0; k <= m; k++)
+    freq_a[k] = remez_response(cos_n[k], r);
+
+  for (int i = 0; i < n; i++) {
+    int step = (i - m + n) % n;
+    int j = 0;
+    double v = freq_a[0];
+
+    for (int k = 1; k <= m; k++) {
+      j += step;
+      if (j >= n) j -= n;
+      v += 2.0 * freq_a[k] * cos_n[j];
+    }
+    design_h[i] = v / n;
+  }
+}
+
+//---------------------------------------------------------------
+// Does h[] (n taps) meet the spec? Measured on the analyser, with the
+// frequencies all normalised to a samplerate of 1.
+static bool meets_spec(const struct filter_spec *s, int n, const double h[]) {
+  struct filter_response r;
+  float32_t pass_max = 0.0, stop_max = -1000.0;
+  float32_t mn, mx;
+
+  for (int i = 0; i < n; i++) check_h[i] = h[i];
+  filter_response_fir_f32(check_h, n, 1.0, 0.0, 0.0, &r);
+
+  for (int b = 0; b < s->nbands; b++) {
+    const struct filter_band *bp = &s->bands[b];
+
+    filter_response_band(bp->lo, bp->hi, &mn, &mx);
+    if (bp->desired > 0.0) {
+      if (mx - mn > FILTER_DESIGN_RIPPLE_DB) return false;
+      pass_max = mx;
+    } else {
+      if (mx > stop_max) stop_max = mx;
+    }
+  }
+
+  return (stop_max - pass_max <= 20.0 * log10(s->dstop));
+}
+
+static void save_design(const double src[], float32_t h[], int n) {
+  for (int i = 0; i < n; i++) h[i] = src[i];
+}
+
+static int clamp_taps(const struct filter_design *d, int n) {
+  n |= 1;
+  if (n < d->nmin) n = d->nmin;
+  if (n > d->nmax) n = d->nmax;
+  return n;
+}
+
+// The trial of d->n taps is over. Pick the next, or finish.
+static void trial_done(struct filter_design *d, float32_t h[], bool ok) {
+  if (ok) {
+    d->pass = d->n;
+    save_design(design_h, h, d->n);
+  } else {
+    d->fail = d->n;
+  }
+
+  // The estimates are close, but not exact. Head out from the first trial
+  // in growing strides until the smallest that passes is between fail and
+  // pass, and then halve the gap.
+  if (d->pass - d->fail > 2) {
+    if (d->pass > d->nmax) {
+      d->n = clamp_taps(d, d->fail + d->stride);
+      d->stride *= 2;
+    } else if (d->fail < d->nmin) {
+      d->n = clamp_taps(d, d->pass - d->stride);
+      d->stride *= 2;
+    } else {
+      d->n = (d->fail + d->pass) / 2;
+      if (!(d->n & 1)) d->n++;
+    }
+    d->stage = STAGE_TRIAL;
+    return;
+  }
+
+  if (d->pass <= d->nmax) {
+    d->best = d->pass;
+  } else {
+    // Nothing met it, so the last trial was the most taps we may have. Use
+    // it if we got as far as a filter, or else fall back to a Kaiser one.
+    if (DEBUG) Serial.printf("Filter spec not met in %d taps\n", d->nmax + 1);
+    if ((d->n != d->nmax) || !d->complete) kaiser_design(&d->spec, d->nmax, design_h);
+    save_design(design_h, h, d->nmax);
+    d->best = d->nmax;
+  }
+
+  h[d->best] = 0;
+
+  if (DEBUG) Serial.printf("Designed %s filter: %d taps\n", (d->method == W_KAISER) ? "Kaiser" : "Remez",
+    d->best + 1);
+
+  d->stage = STAGE_DONE;
+}
+
+int designFilterStart(struct filter_design *d, float32_t h[], int maxtaps, int type, int method,
+    double fc1, double fc2, double transition, double atten, double samplerate) {
+  struct filter_spec *s = &d->spec;
+  int n;
+
+  if ((method != W_KAISER) && (method != W_REMEZ)) return 0;
+  if (!make_spec(s, type, fc1, fc2, transition, atten, samplerate)) return 0;
+
+  // We design odd (type I) filters, and pad with a trailing zero to make
+  // them even for the Teensy FIR.
+  if (maxtaps > MAX_DESIGN_TAPS) maxtaps = MAX_DESIGN_TAPS;
+  d->nmax = ((maxtaps - 1) & 1) ? maxtaps - 1 : maxtaps - 2;
+  d->nmin = FILTER_DESIGN_MIN_TAPS - 1;
+  if (d->nmax < d->nmin) return 0;
+
+  d->method = method;
+  d->fail = d->nmin - 2;
+  d->pass = d->nmax + 2;
+  d->stride = 2;
+  d->stage = STAGE_TRIAL;
+
+  // Something to be going on with - a Kaiser filter, unchecked, of about
+  // the size it needs
+  n = clamp_taps(d, kaiserTapEstimate(-20.0 * log10(fmin(s->dpass, s->dstop)), transition / samplerate));
+  kaiser_design(s, n, design_h);
+  save_design(design_h, h, n);
+  h[n] = 0;
+
+  d->n = (method == W_KAISER) ? n :
+    clamp_taps(d, remezTapEstimate(FILTER_DESIGN_RIPPLE_DB, atten, transition / samplerate));
+
+  return n + 1;
+}
+
+int designFilterStep(struct filter_design *d, float32_t h[]) {
+  switch (d->stage) {
+    case STAGE_TRIAL:
+      d->complete = false;
+      if (d->method == W_KAISER) {
+        // Quick enough to do in one
+        kaiser_design(&d->spec, d->n, design_h);
+        d->converged = true;
+        d->complete = true;
+        d->stage = STAGE_CHECK;
+      } else {
+        d->stage = remez_start(d) ? STAGE_ITERATE : STAGE_CHECK;
+      }
+      break;
+
+    case STAGE_ITERATE:
+      if (remez_iterate(d)) d->stage = STAGE_FINISH;
+      break;
+
+    case STAGE_FINISH:
+      remez_finish(d->n);
+      d->complete = true;
+      d->stage = STAGE_CHECK;
+      break;
+
+    case STAGE_CHECK:
+      trial_done(d, h, d->converged && meets_spec(&d->spec, d->n, design_h));
+      break;
+
+    default:
+      break;
+  }
+
+  return (d->stage == STAGE_DONE) ? d->best + 1 : 0;
+}
+
+int designFilter(float32_t h[], int maxtaps, int type, int method, double fc1, double fc2,
+    double transition, double atten, double samplerate) {
+  struct filter_design d;
+  int taps;
+
+  if (!designFilterStart(&d, h, maxtaps, type, method, fc1, fc2, transition, atten, samplerate)) return 0;
+  while ((taps = designFilterStep(&d, h)) == 0) ;
+  return taps;
+}
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// FIR filter design to a specification, rather than to a fixed number of taps.
+//
+// Give it the passband edges, the width of the transition band(s) and the
+// stopband attenuation you want, and it finds the smallest number of taps that
+// meets them. Two methods:
+//  - Kaiser windowed sinc. Quick to generate, but needs more taps.
+//  - Parks-McClellan (Remez exchange) equiripple. Slower to generate, but
+//    meets the same spec with noticeably fewer taps.
+
+#ifndef FILTERDESIGN_H
+#define FILTERDESIGN_H
+
+// Extra 'window' types for the filterList table, alongside the W_BLACKMAN
+// etc. ones in dynamicFilters.h. These get designed to the spec in the
+// table, and the coeff field is then the maximum number of taps allowed.
+const int W_KAISER =    4;
+const int W_REMEZ =     5;
+
+// Passband ripple we design for, peak to peak.
+#define FILTER_DESIGN_RIPPLE_DB 0.5
+
+// Smallest filter we will generate.
+#define FILTER_DESIGN_MIN_TAPS  6
+
+// Design a filter of TYPE (ID_LOWPASS, ID_HIGHPASS or ID_BANDPASS) with
+// METHOD (W_KAISER or W_REMEZ). fc1/fc2 are the passband edges in Hz - a
+// lowpass or highpass only uses fc1. The stopband starts 'transition' Hz outside
+// of the passband, and should be at least 'atten' dB down.
+//
+// Writes up to maxtaps coefficients into h[], unquantised, and returns how
+// many it used. The count is always even, as the Teensy FIR needs. If the
+// spec cannot be met within maxtaps we return the best maxtaps filter we can,
+// and if the spec makes no sense we return 0 and leave h[] alone.
+extern int designFilter(float32_t h[], int maxtaps, int type, int method, double fc1, double fc2,
+  double transition, double atten, double samplerate);
+
+// The bands a request turns into, normalised to a samplerate of 1
+struct filter_band {
+  double lo, hi;              // 0 to 0.5
+  double desired;
+  double weight;
+};
+
+struct filter_spec {
+  struct filter_band bands[3];
+  int nbands;
+  double dpass;               // Allowed passband deviation, linear
+  double dstop;               // Allowed stopband level, linear
+  double cutlo, cuthi;        // Ideal cutoffs for the windowed sinc
+};
+
+// The same design as designFilter(), done a step at a time, so it can run in
+// the main loop without holding up the audio. A step is one Remez iteration,
+// or one check of a trial filter against the spec. The number of taps is
+// found by bisection, from the estimate outwards.
+//
+// Only one can be in progress at a time, as they share the Remez working
+// storage - as does designFilter().
+struct filter_design {
+  struct filter_spec spec;
+  int method;
+  int nmin, nmax;             // Odd tap counts we may use
+  int fail, pass;             // Most that failed, fewest that passed - nmin-2 and nmax+2 if none yet
+  int stride;                 // How far out the next trial goes, until the answer is between the two
+  int n;                      // Trial in progress
+  int stage;
+  int iter, gridsize;
+  bool converged;
+  bool complete;              // The trial got as far as all n taps of a filter
+  int best;                   // Taps, less the padding, once done
+};
+
+// Start designing into h[], as designFilter(). To be going on with, writes a
+// Kaiser filter of the estimated size for the spec into h[], and returns its
+// taps - or 0, as designFilter(), if the spec makes no sense.
+extern int designFilterStart(struct filter_design *d, float32_t h[], int maxtaps, int type, int method,
+  double fc1, double fc2, double transition, double atten, double samplerate);
+
+// Take the next step. Returns 0 until the design is done, and then the
+// taps now in h[], as designFilter(). h[] gets overwritten along the way.
+extern int designFilterStep(struct filter_design *d, float32_t h[]);
+
+// Estimate the taps needed for a spec, before we go searching for it.
+// Normalised transition width (transition/samplerate).
+extern int kaiserTapEstimate(double atten, double dF);
+extern int remezTapEstimate(double ripple_db, double atten, double dF);
+
+#endif
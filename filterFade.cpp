@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+#include <Audio.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "dspfilter.h"
+#include "filterFade.h"
+
+static AudioFilterFIR *const filters[2] = { &firfilter, &firfilter_b };
+static short *const coeff_buffers[2] = { fir_active1, fir_active2 };
+
+static int active = 0;        //Which filter is (or is becoming) the one we listen to
+static bool fading = false;
+static unsigned long fade_start_us;
+static float32_t fade_gain;   //Last gain we gave the newly active filter
+
+void filter_fade_init(void) {
+  active = 0;
+  fading = false;
+  fir_mixer.gain(0, 1.0);
+  fir_mixer.gain(1, 0.0);
+  fir_mixer.gain(2, 0.0);
+  fir_mixer.gain(3, 0.0);
+}
+
+bool filter_fade_busy(void) {
+  return fading;
+}
+
+void filter_fade_start(const short *coeffs, int ncoeffs) {
+  int next = active ^ 1;
+
+  //Should not happen - callers check busy first. Snap the last fade to its end.
+  if (fading) {
+    fir_mixer.gain(active, 1.0);
+    fir_mixer.gain(active ^ 1, 0.0);
+    filters[active ^ 1]->end();
+  }
+
+  fir_mixer.gain(next, 0.0);
+  if (coeffs == FIR_PASSTHRU) {
+    filters[next]->begin(FIR_PASSTHRU, 0);
+  } else {
+    memcpy(coeff_buffers[next], coeffs, sizeof(short) * ncoeffs);
+    filters[next]->begin(coeff_buffers[next], ncoeffs);
+  }
+
+  active = next;
+  fade_gain = 0.0;
+  fade_start_us = micros();
+  fading = true;
+}
+
+void filter_fade_service(void) {
+  float32_t g;
+
+  if (!fading) return;
+
+  g = (float32_t)(micros() - fade_start_us) / (FILTER_FADE_MS * 1000.0);
+  if (g >= 1.0) {
+    fir_mixer.gain(active, 1.0);
+    fir_mixer.gain(active ^ 1, 0.0);
+    //Stop the old filter - it then costs us no CPU, and outputs nothing.
+    filters[active ^ 1]->end();
+    fading = false;
+    return;
+  }
+
+  //No point poking the mixer more often than it processes a block
+  if (g - fade_gain < (1000.0 * AUDIO_BLOCK_SAMPLES / SAMPLE_RATE) / FILTER_FADE_MS) return;
+
+  fade_gain = g;
+  fir_mixer.gain(active, g);
+  fir_mixer.gain(active ^ 1, 1.0 - g);
+}
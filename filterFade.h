@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Glitch free switching of the user FIR filter.
+//
+// There are two FIR filters in the audio graph, fed from the same input and
+// summed in fir_mixer. Only one normally runs. New coefficients are loaded into
+// the idle one, and the mixer then fades across from the old filter to the new,
+// so we do not get a click from swapping coefficients mid stream.
+
+#ifndef FILTERFADE_H
+#define FILTERFADE_H
+
+// How long to take fading from the old to the new filter.
+// The mixer updates its gain once per audio block (~2.9ms), so this gives
+// us a ramp of a handful of steps.
+#define FILTER_FADE_MS 20
+
+extern void filter_fade_init(void);
+
+// True whilst a fade is in progress - a new filter cannot be loaded until
+// it has finished.
+extern bool filter_fade_busy(void);
+
+// Load the coefficients into the idle filter and start fading over to it.
+// The coefficients are copied, so the caller can re-use its buffer.
+// Pass FIR_PASSTHRU to fade over to no FIR filtering at all.
+extern void filter_fade_start(const short *coeffs, int ncoeffs);
+
+// Step the fade along. Call from the main loop.
+extern void filter_fade_service(void);
+
+#endif
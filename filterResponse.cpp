@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+#include <Audio.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "iirDesign.h"
+#include "filterResponse.h"
+
+static DMAMEM float32_t resp_buf[FILTER_RESPONSE_FFT_SIZE];
+static DMAMEM float32_t resp_fft[FILTER_RESPONSE_FFT_SIZE];
+static DMAMEM float32_t resp_mag[FILTER_RESPONSE_BINS];
+static DMAMEM float32_t resp_phase[FILTER_RESPONSE_BINS];
+
+static arm_rfft_fast_instance_f32 resp_rfft;
+static bool resp_rfft_ready = false;
+static float32_t resp_rate = 1.0;
+
+static float32_t to_db(float32_t g) {
+  if (g < 1e-10) g = 1e-10;
+  return 20.0 * log10f(g);
+}
+
+static float32_t bin_hz(void) {
+  return resp_rate / FILTER_RESPONSE_FFT_SIZE;
+}
+
+// Walk out from the peak until we drop 'down' dB below it, and interpolate
+// where between the two bins we crossed. dir is -1 to go down in frequency,
+// +1 to go up.
+static float32_t find_edge(int peak, float32_t down, int dir) {
+  float32_t target = to_db(resp_mag[peak]) - down;
+  int i = peak;
+
+  while (true) {
+    int next = i + dir;
+    float32_t db_i, db_next, frac;
+
+    if ((next < 0) || (next >= FILTER_RESPONSE_BINS)) break;
+
+    db_next = to_db(resp_mag[next]);
+    if (db_next < target) {
+      db_i = to_db(resp_mag[i]);
+      frac = (db_i - target) / (db_i - db_next);
+      return ((float32_t)i + dir * frac) * bin_hz();
+    }
+    i = next;
+  }
+
+  return (dir < 0) ? 0.0 : resp_rate / 2.0;
+}
+
+// resp_buf holds the (zero padded) impulse response - transform it, and
+// work out the figures.
+static void analyse(float32_t pass_lo, float32_t pass_hi, struct filter_response *r) {
+  int peak = 0;
+  float32_t mn, mx;
+
+  if (!resp_rfft_ready) {
+    arm_rfft_fast_init_f32(&resp_rfft, FILTER_RESPONSE_FFT_SIZE);
+    resp_rfft_ready = true;
+  }
+
+  arm_rfft_fast_f32(&resp_rfft, resp_buf, resp_fft, 0);
+
+  // DC and Nyquist come packed into the first pair as real values
+  resp_mag[0] = fabsf(resp_fft[0]);
+  resp_phase[0] = (resp_fft[0] < 0.0) ? PI : 0.0;
+  resp_mag[FILTER_RESPONSE_BINS - 1] = fabsf(resp_fft[1]);
+  resp_phase[FILTER_RESPONSE_BINS - 1] = (resp_fft[1] < 0.0) ? PI : 0.0;
+  arm_cmplx_mag_f32(&resp_fft[2], &resp_mag[1], FILTER_RESPONSE_BINS - 2);
+  for (int i = 1; i < FILTER_RESPONSE_BINS - 1; i++)
+    resp_phase[i] = atan2f(resp_fft[i * 2 + 1], resp_fft[i * 2]);
+
+  for (int i = 1; i < FILTER_RESPONSE_BINS; i++)
+    if (resp_mag[i] > resp_mag[peak]) peak = i;
+
+  r->samplerate = resp_rate;
+  r->peak_gain = resp_mag[peak];
+  r->peak_freq = peak * bin_hz();
+  r->edge3_lo = find_edge(peak, 3.0, -1);
+  r->edge3_hi = find_edge(peak, 3.0, 1);
+  r->edge60_lo = find_edge(peak, 60.0, -1);
+  r->edge60_hi = find_edge(peak, 60.0, 1);
+
+  if (pass_hi <= pass_lo) {
+    pass_lo = r->edge3_lo;
+    pass_hi = r->edge3_hi;
+  }
+  filter_response_band(pass_lo, pass_hi, &mn, &mx);
+  r->ripple_db = mx - mn;
+}
+
+void filter_response_fir_q15(const short *coeffs, int ntaps, float32_t samplerate,
+    float32_t pass_lo, float32_t pass_hi, struct filter_response *r) {
+  if (ntaps > FILTER_RESPONSE_FFT_SIZE) ntaps = FILTER_RESPONSE_FFT_SIZE;
+
+  for (int i = 0; i < ntaps; i++) resp_buf[i] = (float32_t)coeffs[i] / 32768.0;
+  for (int i = ntaps; i < FILTER_RESPONSE_FFT_SIZE; i++) resp_buf[i] = 0.0;
+
+  resp_rate = samplerate;
+  analyse(pass_lo, pass_hi, r);
+}
+
+void filter_response_fir_f32(const float32_t *coeffs, int ntaps, float32_t samplerate,
+    float32_t pass_lo, float32_t pass_hi, struct filter_response *r) {
+  if (ntaps > FILTER_RESPONSE_FFT_SIZE) ntaps = FILTER_RESPONSE_FFT_SIZE;
+
+  memcpy(resp_buf, coeffs, sizeof(float32_t) * ntaps);
+  for (int i = ntaps; i < FILTER_RESPONSE_FFT_SIZE; i++) resp_buf[i] = 0.0;
+
+  resp_rate = samplerate;
+  analyse(pass_lo, pass_hi, r);
+}
+
+void filter_response_iir(const float32_t *coeffs, int stages, float32_t samplerate,
+    float32_t pass_lo, float32_t pass_hi, struct filter_response *r) {
+  arm_biquad_cascade_df2T_instance_f32 iir;
+  float32_t state[IIR_MAX_STAGES * 2];
+
+  if (stages > IIR_MAX_STAGES) stages = IIR_MAX_STAGES;
+
+  // Impulse in, impulse response out
+  for (int i = 0; i < FILTER_RESPONSE_FFT_SIZE; i++) resp_buf[i] = 0.0;
+  resp_buf[0] = 1.0;
+  arm_biquad_cascade_df2T_init_f32(&iir, stages, coeffs, state);
+  arm_biquad_cascade_df2T_f32(&iir, resp_buf, resp_buf, FILTER_RESPONSE_FFT_SIZE);
+
+  resp_rate = samplerate;
+  analyse(pass_lo, pass_hi, r);
+}
+
+void filter_response_band(float32_t lo, float32_t hi, float32_t *min_db, float32_t *max_db) {
+  int first = (int)ceilf(lo / bin_hz());
+  int last = (int)floorf(hi / bin_hz());
+  float32_t mn = 1e30, mx = 0.0;
+
+  if (first < 0) first = 0;
+  if (last > FILTER_RESPONSE_BINS - 1) last = FILTER_RESPONSE_BINS - 1;
+  //Narrower than a bin - use the nearest one
+  if (last < first) {
+    first = last = (int)((lo + hi) / 2.0 / bin_hz() + 0.5);
+    if (first > FILTER_RESPONSE_BINS - 1) first = last = FILTER_RESPONSE_BINS - 1;
+  }
+
+  for (int i = first; i <= last; i++) {
+    if (resp_mag[i] < mn) mn = resp_mag[i];
+    if (resp_mag[i] > mx) mx = resp_mag[i];
+  }
+
+  *min_db = to_db(mn);
+  *max_db = to_db(mx);
+}
+
+const float32_t *filter_response_magnitude(void) {
+  return resp_mag;
+}
+
+const float32_t *filter_response_phase(void) {
+  return resp_phase;
+}
+
+void filter_response_print(const char *name, const struct filter_response *r) {
+  Serial.printf("%s: peak %.3f (%.1fdB) @%.0fHz, ripple %.2fdB, -3dB %.0f-%.0fHz, -60dB %.0f-%.0fHz\n",
+    name, r->peak_gain, to_db(r->peak_gain), r->peak_freq, r->ripple_db,
+    r->edge3_lo, r->edge3_hi, r->edge60_lo, r->edge60_hi);
+}
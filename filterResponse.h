@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Frequency response analysis of a set of filter coefficients.
+//
+// The impulse response is zero padded out to FILTER_RESPONSE_FFT_SIZE and
+// put through a single real FFT, which gets us the magnitude and phase at
+// every bin in one go. From that we find the true peak gain, the passband
+// ripple and the -3dB and -60dB edges.
+//
+// IIR filters are analysed from their impulse response, truncated to the
+// FFT size - plenty for anything stable enough to use.
+
+#ifndef FILTERRESPONSE_H
+#define FILTERRESPONSE_H
+
+#include <arm_math.h>
+
+#define FILTER_RESPONSE_FFT_SIZE  4096
+#define FILTER_RESPONSE_BINS      (FILTER_RESPONSE_FFT_SIZE / 2 + 1)
+
+struct filter_response {
+  float32_t samplerate;
+  float32_t peak_gain;        // Linear
+  float32_t peak_freq;        // Hz
+  float32_t ripple_db;        // Peak to trough, across the passband asked for
+  float32_t edge3_lo;         // -3dB (relative to peak) edges, Hz
+  float32_t edge3_hi;
+  float32_t edge60_lo;        // -60dB edges, Hz. 0 or samplerate/2 if we never get that far down
+  float32_t edge60_hi;
+};
+
+// Analyse a filter. pass_lo/pass_hi (Hz) are the passband to measure the
+// ripple across - pass 0, 0 to use the -3dB points instead.
+extern void filter_response_fir_q15(const short *coeffs, int ntaps, float32_t samplerate,
+  float32_t pass_lo, float32_t pass_hi, struct filter_response *r);
+extern void filter_response_fir_f32(const float32_t *coeffs, int ntaps, float32_t samplerate,
+  float32_t pass_lo, float32_t pass_hi, struct filter_response *r);
+// CMSIS df2T ordered biquads: b0, b1, b2, a1, a2 per stage
+extern void filter_response_iir(const float32_t *coeffs, int stages, float32_t samplerate,
+  float32_t pass_lo, float32_t pass_hi, struct filter_response *r);
+
+// Lowest and highest gain, in dB, between lo and hi Hz, of the filter last
+// analysed.
+extern void filter_response_band(float32_t lo, float32_t hi, float32_t *min_db, float32_t *max_db);
+
+// Magnitude (linear) and phase (radians) of the last analysis, by bin.
+// Bin n is at n * samplerate / FILTER_RESPONSE_FFT_SIZE.
+extern const float32_t *filter_response_magnitude(void);
+extern const float32_t *filter_response_phase(void);
+
+// Print a summary out of the serial port.
+extern void filter_response_print(const char *name, const struct filter_response *r);
+
+#endif
@@ -1,2 +1,3 @@
 
 extern void calc_FIR_coeffs (float * coeffs_I, int numCoeffs, float32_t fc, float32_t Astop, int type, float dfc, float Fsamprate);
+extern float32_t Izero (float32_t x);
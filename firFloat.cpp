@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+#include <Audio.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "dynamicFilters.h"
+#include "filterDesign.h"
+#include "filterResponse.h"
+#include "firFloat.h"
+
+#define FIR_FLOAT_FRAME (AUDIO_BLOCK_SAMPLES * N_BLOCKS)
+
+static arm_fir_instance_f32 fir_inst[2];
+static float32_t fir_coeffs[2][NUM_COEFFICIENTS];
+static DMAMEM float32_t fir_state[2][NUM_COEFFICIENTS + FIR_FLOAT_FRAME - 1];
+
+static int fir_current = -1;    //Which instance we are listening to, -1 for none
+static int fir_previous = -1;   //and which we are fading out from
+static bool fir_fading = false;
+
+static DMAMEM float32_t fir_fade_buf[FIR_FLOAT_FRAME];
+
+void fir_float_start(const float32_t *coeffs, int ntaps) {
+  int next = (fir_current == 0) ? 1 : 0;
+
+  memcpy(fir_coeffs[next], coeffs, sizeof(float32_t) * ntaps);
+  //Zeros the state for us as well
+  arm_fir_init_f32(&fir_inst[next], ntaps, fir_coeffs[next], fir_state[next], FIR_FLOAT_FRAME);
+
+  fir_previous = fir_current;
+  fir_current = next;
+  fir_fading = true;
+}
+
+void fir_float_stop(void) {
+  if (fir_current < 0) return;
+
+  fir_previous = fir_current;
+  fir_current = -1;
+  fir_fading = true;
+}
+
+bool fir_float_active(void) {
+  return (fir_current >= 0) || fir_fading;
+}
+
+bool fir_float_busy(void) {
+  return fir_fading;
+}
+
+void fir_float_process(const float32_t *src, float32_t *dst, uint32_t blockSize) {
+  if (blockSize > FIR_FLOAT_FRAME) blockSize = FIR_FLOAT_FRAME;
+
+  if (fir_current >= 0) arm_fir_f32(&fir_inst[fir_current], src, dst, blockSize);
+  else memcpy(dst, src, sizeof(float32_t) * blockSize);
+
+  if (!fir_fading) return;
+
+  // Run the old filter too, and cross fade over the frame. 'No filter' is
+  // just the input as is.
+  if (fir_previous >= 0) arm_fir_f32(&fir_inst[fir_previous], src, fir_fade_buf, blockSize);
+  else memcpy(fir_fade_buf, src, sizeof(float32_t) * blockSize);
+
+  for (uint32_t i = 0; i < blockSize; i++) {
+    float32_t g = (float32_t)i / (float32_t)blockSize;
+    dst[i] = (dst[i] * g) + (fir_fade_buf[i] * (1.0 - g));
+  }
+
+  fir_fading = false;
+}
+
+// Worst stopband level, relative to the peak, of the filter last analysed
+static float32_t stop_depth(float32_t stop_lo, float32_t stop_hi, const struct filter_response *r) {
+  float32_t mn, mx, worst = -200.0;
+
+  if (stop_lo > 0.0) {
+    filter_response_band(0.0, stop_lo, &mn, &mx);
+    if (mx > worst) worst = mx;
+  }
+  if (stop_hi < SAMPLE_RATE / 2.0) {
+    filter_response_band(stop_hi, SAMPLE_RATE / 2.0, &mn, &mx);
+    if (mx > worst) worst = mx;
+  }
+  return worst - 20.0 * log10f(r->peak_gain);
+}
+
+void fir_float_benchmark(void) {
+  static const struct {
+    const char *name;
+    int method;
+    float32_t fc1, fc2, transition, atten;
+  } specs[] = {
+    { "SSB Remez 50dB", W_REMEZ, 300.0, 2700.0, 600.0, 50.0 },
+    { "Kaiser 80dB", W_KAISER, 1500.0, 2500.0, 1200.0, 80.0 },
+  };
+  static float32_t fcoeffs[NUM_COEFFICIENTS];
+  static short qcoeffs[NUM_COEFFICIENTS];
+  static float32_t fin[FIR_FLOAT_FRAME], fout[FIR_FLOAT_FRAME];
+  static q15_t qin[FIR_FLOAT_FRAME], qout[FIR_FLOAT_FRAME];
+  static float32_t fstate[NUM_COEFFICIENTS + FIR_FLOAT_FRAME - 1];
+  static q15_t qstate[NUM_COEFFICIENTS + AUDIO_BLOCK_SAMPLES];
+  arm_fir_instance_f32 ffir;
+  arm_fir_instance_q15 qfir;
+  struct filter_response r;
+  uint32_t fcycles, qcycles;
+  float32_t fdepth, qdepth;
+  int taps;
+
+  for (int i = 0; i < FIR_FLOAT_FRAME; i++) qin[i] = (q15_t)(random(-16384, 16384));
+  arm_q15_to_float(qin, fin, FIR_FLOAT_FRAME);
+
+  Serial.println("FIR coefficient benchmark, float vs q15:");
+
+  for (unsigned s = 0; s < sizeof(specs) / sizeof(specs[0]); s++) {
+    taps = designFilter(fcoeffs, NUM_COEFFICIENTS, ID_BANDPASS, specs[s].method, specs[s].fc1, specs[s].fc2,
+      specs[s].transition, specs[s].atten, SAMPLE_RATE);
+    if (taps == 0) continue;
+
+    //Scale to the same 0.9 peak the filter cache uses, before we quantise
+    filter_response_fir_f32(fcoeffs, taps, SAMPLE_RATE, specs[s].fc1, specs[s].fc2, &r);
+    normaliseCoeffsFloat(fcoeffs, taps, 0.9 / r.peak_gain);
+    arm_float_to_q15(fcoeffs, qcoeffs, taps);
+
+    filter_response_fir_f32(fcoeffs, taps, SAMPLE_RATE, specs[s].fc1, specs[s].fc2, &r);
+    fdepth = stop_depth(specs[s].fc1 - specs[s].transition, specs[s].fc2 + specs[s].transition, &r);
+    filter_response_fir_q15(qcoeffs, taps, SAMPLE_RATE, specs[s].fc1, specs[s].fc2, &r);
+    qdepth = stop_depth(specs[s].fc1 - specs[s].transition, specs[s].fc2 + specs[s].transition, &r);
+
+    arm_fir_init_f32(&ffir, taps, fcoeffs, fstate, FIR_FLOAT_FRAME);
+    fcycles = ARM_DWT_CYCCNT;
+    arm_fir_f32(&ffir, fin, fout, FIR_FLOAT_FRAME);
+    fcycles = ARM_DWT_CYCCNT - fcycles;
+
+    // q15 goes a block at a time, as AudioFilterFIR does
+    arm_fir_init_q15(&qfir, taps, qcoeffs, qstate, AUDIO_BLOCK_SAMPLES);
+    qcycles = ARM_DWT_CYCCNT;
+    for (int i = 0; i < N_BLOCKS; i++)
+      arm_fir_fast_q15(&qfir, &qin[i * AUDIO_BLOCK_SAMPLES], &qout[i * AUDIO_BLOCK_SAMPLES], AUDIO_BLOCK_SAMPLES);
+    qcycles = ARM_DWT_CYCCNT - qcycles;
+
+    Serial.printf(" %s, %d taps: float %.1fdB %u cycles, q15 %.1fdB %u cycles\n", specs[s].name, taps,
+      fdepth, (unsigned)fcycles, qdepth, (unsigned)qcycles);
+  }
+}
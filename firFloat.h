@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// The user bandpass FIR, run in float on the main loop, before decimation.
+//
+// Running from float coefficients means they never get truncated to 16 bits,
+// so we get the full stopband depth of the design. The AudioFilterFIR path
+// (see filterFade.h) is still there as a lower cost option - FIR_PATH_Q15.
+//
+// As with the other filters, there are two sets of state so a new filter can
+// be faded in over one frame.
+
+#ifndef FIRFLOAT_H
+#define FIRFLOAT_H
+
+#include <arm_math.h>
+
+// Fade over to a new filter. Coefficients are copied.
+extern void fir_float_start(const float32_t *coeffs, int ntaps);
+
+// Fade back out to no float FIR at all.
+extern void fir_float_stop(void);
+
+// True if fir_float_process() needs calling - we have a filter, or are
+// fading one in or out.
+extern bool fir_float_active(void);
+
+// True until the last start/stop has been faded in.
+extern bool fir_float_busy(void);
+
+// Filter a frame at the full samplerate, from src into dst.
+extern void fir_float_process(const float32_t *src, float32_t *dst, uint32_t blockSize);
+
+// Compare stopband depth, and cycles, of float against q15 coefficients,
+// and print the results out the serial port.
+extern void fir_float_benchmark(void);
+
+#endif
@@ -39,6 +39,9 @@ int decoder_mode = DECODER_OFF;
 // 600 (Hz) * 0.024 (S) == 14.4 cycles for a very fast 'dit'
 int morse_cycles = 14;
 int morse_frequency = 600;
+int pitch_track = 0;
+int key_source = KEY_SOURCE_ENVELOPE;
+int text_tap = TEXT_TAP_OFF;
 float32_t morse_threshold = 0.01;   //Pretty low by default.
 
 // noise blanker by Michael Wild
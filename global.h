@@ -69,19 +69,34 @@ extern float32_t DMAMEM NR_Gts[NR_FFT_L / 2][2]; // time smoothed gain factors (
 #define DECODER_MORSE 1
 #define DECODER_MORSE_K4ICY 2
 #define DECODER_MORSE_TF3LJ 3
+#define DECODER_SKIMMER 4      //Every carrier at once, out over USB - see skimmer.h
+#define DECODER_ENSEMBLE 5     //All three at once, and vote - see ensemble.h
+#define DECODER_MORSE_HMM 6    //Probabilistic - see morseHmm.h
 extern int decoder_mode;
 
 //For morse decoder
 extern int morse_cycles;
 extern int morse_frequency;
+extern int pitch_track;     //Follow the CW pitch - see pitchTrack.cpp
+#define KEY_SOURCE_ENVELOPE 0   //Our own envelope detector - see envelope.h
+#define KEY_SOURCE_LEGACY 1     //The tone detector, or TF3LJ's own spectrum
+extern int key_source;
+#define TEXT_TAP_OFF 0          //Decoded text to the LCD only
+#define TEXT_TAP_ON 1           //... and out over USB serial - see textSink.h
+extern int text_tap;
 extern float32_t morse_threshold;
 extern AudioAnalyzeToneDetect toneDetect;
 
 // FIR filter stuff
 #define NUM_COEFFICIENTS  200
-extern AudioFilterFIR firfilter;
+extern AudioFilterFIR firfilter, firfilter_b;
+extern AudioMixer4 fir_mixer;
 extern short   fir_active1[];
+extern short   fir_active2[];
 extern int current_filter_mode;
+#define FIR_PATH_FLOAT 0    //Float coefficients, run on the main loop
+#define FIR_PATH_Q15 1      //16 bit coefficients, in the AudioFilterFIR. Cheaper, but not so deep.
+extern int fir_path;
 extern void updateFilter();
 
 extern bool nb_enabled;
@@ -98,6 +113,7 @@ extern bool xanr_notch;
 #define AGC_MODE_OFF 0    //Just pass on through
 #define AGC_MODE_TRACK 1  //Try to track output peak/mean to input in sw
 #define AGC_MODE_SG5K 2   //Enable the SGTL5000 AGC unit
+#define AGC_MODE_SW 3     //Software AGC and limiter on the decimated data - see agc.cpp
 
 extern int agc_mode;
 
@@ -136,7 +152,3 @@ extern bool display;
 // is no way to tell when we are *not* connected to USB?
 // Maybe that is a feature to add to the prjc audio library..
 extern float32_t global_volume;    //A good default volume
-
-
-//TF3LJ morse decoder
-extern AudioAnalyzeFFT256 morse_fft;
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// CPU budget governor - see governor.h
+
+#include <Audio.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "governor.h"
+#include "settings.h"
+#include "morseGen.h"
+#include "xanr.h"
+#include "ik8yfw.h"
+
+#define FRAME_US ((unsigned long)(1000000.0 * AUDIO_BLOCK_SAMPLES * N_BLOCKS / SAMPLE_RATE))
+
+static const char *rung_names[GOV_RUNGS] = {
+  "anr taps", "nb gate", "nr light", "decode off"
+};
+
+static bool engaged[GOV_RUNGS];
+static int level = 0;
+static int over_frames = 0;
+static unsigned long under_since = 0;
+static unsigned long restored_at = 0;
+static unsigned long restore_ms = GOVERNOR_RESTORE_MS;
+static bool exhausted = false;
+
+static bool nr_is_heavy(int mode) {
+  return (mode == NR_MODE_LMS) || (mode == NR_MODE_KIM) ||
+    (mode == NR_MODE_SPECTRAL) || (mode == NR_MODE_LLMS);
+}
+
+// Would taking this rung save us anything right now?
+static bool rung_applies(int rung) {
+  if (nr_mode == NR_MODE_COMPLETE_BYPASS) return false;
+
+  switch (rung) {
+    case GOV_ANR_TAPS:
+      return (xanr_notch || (nr_mode == NR_MODE_LLMS)) && (ANR_taps > GOVERNOR_ANR_MIN_TAPS);
+    case GOV_NB_GATE:
+      return nb_enabled;
+    case GOV_NR_LIGHT:
+      return nr_is_heavy(nr_mode);
+    case GOV_DECODE_OFF:
+      return decoder_mode != DECODER_OFF;
+  }
+  return false;
+}
+
+static void engage(int rung) {
+  switch (rung) {
+    case GOV_ANR_TAPS:
+      ANR_taps_max = ANR_taps / 2;
+      if (ANR_taps_max < GOVERNOR_ANR_MIN_TAPS) ANR_taps_max = GOVERNOR_ANR_MIN_TAPS;
+      break;
+    case GOV_NR_LIGHT:
+      fnrFilter_init(&fnr_state);
+      break;
+    case GOV_DECODE_OFF:
+      morseLed(false);
+      break;
+  }
+  engaged[rung] = true;
+  level++;
+}
+
+static void release(int rung) {
+  switch (rung) {
+    case GOV_ANR_TAPS:
+      ANR_taps_max = ANR_DLINE_SIZE;
+      break;
+    case GOV_NR_LIGHT:
+      //The user's NR has been sat idle - start it from fresh
+      set_nr_mode(nr_mode);
+      break;
+  }
+  engaged[rung] = false;
+  level--;
+}
+
+void governor_reset(void) {
+  for (int i = 0; i < GOV_RUNGS; i++) engaged[i] = false;
+  ANR_taps_max = ANR_DLINE_SIZE;
+  level = 0;
+  exhausted = false;
+  over_frames = 0;
+  under_since = millis();
+  restore_ms = GOVERNOR_RESTORE_MS;
+}
+
+void governor_frame(unsigned long used_us) {
+  unsigned long ms = millis();
+  int load = (int)(used_us * 100 / FRAME_US);
+
+  if (load < GOVERNOR_LOW_PC) {
+    over_frames = 0;
+
+    if ((level > 0) && (ms - under_since >= restore_ms)) {
+      for (int i = GOV_RUNGS - 1; i >= 0; i--) {
+        if (engaged[i]) {
+          release(i);
+          exhausted = false;
+          if (DEBUG) Serial.printf("Governor: load %d%%, restored %s (level %d)\n", load, rung_names[i], level);
+          break;
+        }
+      }
+      restored_at = ms;
+      under_since = ms;
+    }
+    return;
+  }
+
+  under_since = ms;
+  if (load < GOVERNOR_HIGH_PC) {
+    over_frames = 0;
+    return;
+  }
+
+  if (++over_frames < GOVERNOR_OVER_FRAMES) return;
+  over_frames = 0;
+
+  for (int i = 0; i < GOV_RUNGS; i++) {
+    if (!engaged[i] && rung_applies(i)) {
+      engage(i);
+      if (DEBUG) Serial.printf("Governor: load %d%%, engaged %s (level %d)\n", load, rung_names[i], level);
+
+      // Did the last restore put us straight back here? Wait longer next time.
+      if ((restored_at != 0) && (ms - restored_at < restore_ms)) {
+        restore_ms *= 2;
+        if (restore_ms > GOVERNOR_RESTORE_MAX_MS) restore_ms = GOVERNOR_RESTORE_MAX_MS;
+      } else {
+        restore_ms = GOVERNOR_RESTORE_MS;
+      }
+      return;
+    }
+  }
+
+  if (DEBUG && !exhausted) Serial.printf("Governor: load %d%%, nothing left to shed\n", load);
+  exhausted = true;
+}
+
+int governor_level(void) {
+  return level;
+}
+
+bool governor_nb_gate(void) {
+  return engaged[GOV_NB_GATE];
+}
+
+int governor_nr_mode(int mode) {
+  if (engaged[GOV_NR_LIGHT] && nr_is_heavy(mode)) return NR_MODE_FNR;
+  return mode;
+}
+
+bool governor_decode_suspended(void) {
+  return engaged[GOV_DECODE_OFF];
+}
+
+char governor_marker(void) {
+  return level ? '0' + level : ' ';
+}
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// CPU budget governor.
+//
+// Some setting combinations (spectral NR, plus the blanker, plus the notch,
+// plus a decoder...) need more time than we have per frame, and then the
+// audio just glitches. The governor watches how long each frame takes to
+// process, and if we keep running over, steps down a ladder of cheaper
+// options. Once we have had plenty of headroom for a while it steps back up,
+// one rung at a time. The user's own settings are never changed.
+
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <Arduino.h>
+
+// Rungs of the ladder, in the order we take them. Rungs that would not
+// change anything with the current settings are skipped.
+enum governor_rung {
+  GOV_ANR_TAPS,     // Fewer autonotch/LLMS taps
+  GOV_NB_GATE,      // Simple impulse gate instead of the LPC blanker
+  GOV_NR_LIGHT,     // Heavier NR modes drop to FNR
+  GOV_DECODE_OFF,   // Decoders suspended
+  GOV_RUNGS
+};
+
+// Percentage of the frame time we are happy to use, and how far under that we
+// must get before we restore anything.
+#define GOVERNOR_HIGH_PC      85
+#define GOVERNOR_LOW_PC       60
+
+// Frames in a row over the top before we step down.
+#define GOVERNOR_OVER_FRAMES  3
+
+// How long we must stay under the low mark before restoring a rung. If a
+// restore puts us straight back over, this doubles, up to the max.
+#define GOVERNOR_RESTORE_MS   3000
+#define GOVERNOR_RESTORE_MAX_MS 60000
+
+// Fewest taps we will cut the LMS down to
+#define GOVERNOR_ANR_MIN_TAPS 16
+
+// Hand over the micros taken to process this frame.
+extern void governor_frame(unsigned long used_us);
+
+// Back to everything on - for when the user loads new settings.
+extern void governor_reset(void);
+
+// How many rungs are engaged, 0 for none.
+extern int governor_level(void);
+
+extern bool governor_nb_gate(void);
+
+// The NR mode to actually run, for the user's mode.
+extern int governor_nr_mode(int mode);
+
+extern bool governor_decode_suspended(void);
+
+// Status line marker - ' ' when we are running everything.
+extern char governor_marker(void);
+
+#endif
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Decoder benchmark on a PC.
+//
+// The decoders, the CW generator and the envelope detector are plain C on
+// top of a little of the Teensy core and CMSIS, so they build here against
+// the stubs in stubs/, and run the very same morse_benchmark() as a DEBUG
+// build does at start up. The character error rates are the same as on the
+// Teensy. The CPU figures are host time scaled to a 600MHz clock - good for
+// comparing one decoder with another, or before with after, and no more.
+//
+//    make -C host bench
+
+#include <Arduino.h>
+#include <arm_math.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "global.h"
+#include "morseBench.h"
+#include "morseDecode.h"
+#include "morseGen.h"
+#include "morseHmm.h"
+#include "k4icy.h"
+#include "tf3lj.h"
+#include "tf3lj_dec.h"
+
+HostSerial Serial;
+
+int morse_frequency = 600;
+
+size_t HostSerial::print(const char *s) {
+  return fputs(s, stdout);
+}
+
+size_t HostSerial::print(char c) {
+  return putchar(c);
+}
+
+size_t HostSerial::println(const char *s) {
+  return puts(s);
+}
+
+size_t HostSerial::printf(const char *fmt, ...) {
+  va_list ap;
+  int n;
+
+  va_start(ap, fmt);
+  n = vprintf(fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+// CPU time of this thread, to the ns - clock() only ticks every us or so,
+// which is most of what one call into a decoder takes
+uint32_t host_cycles(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint32_t)((ts.tv_sec * 1000000000ULL + ts.tv_nsec) * (F_CPU_ACTUAL / 1000000000.0));
+}
+
+// The decoders time the morse by what we hand them, and only use this for
+// where the benchmark starts its clock from, and to guard against hanging.
+// Some of them take 0 to mean "not yet", so start about where a Teensy
+// would be by the end of setup().
+unsigned long millis(void) {
+  return 1000 + clock() / (CLOCKS_PER_SEC / 1000);
+}
+
+// morseGen.cpp has the real one, which only gets as far as the benchmark
+// while it is running
+void morsePrint(char c) {
+  morse_bench_capture(c);
+}
+
+void morseLed(bool on) {
+}
+
+// As decoder_key() in DSPham.ino
+static void decoder_key(int mode, bool down, unsigned long now) {
+  if (mode == DECODER_MORSE_TF3LJ) {
+    tf3lj_key(down, now);
+    sig_incount = sig_lastrx;
+    cur_time = sig_timer;
+    CW_Decode();
+    return;
+  }
+
+  if (mode == DECODER_MORSE_HMM) {
+    hmm_key(down, now);
+    return;
+  }
+
+  if (down) {
+    if (mode == DECODER_MORSE) morseKeyDown(now);
+    if (mode == DECODER_MORSE_K4ICY) k4icy_keyDown(now);
+  } else {
+    if (mode == DECODER_MORSE) morseKeyUp(now);
+    if (mode == DECODER_MORSE_K4ICY) k4icy_keyUp(now);
+  }
+}
+
+int main(void) {
+  morseReset();
+  k4icy_setup();
+  tf3lj_init();
+  tf3lj_dec_init();
+  hmm_init();
+
+  morse_benchmark(decoder_key, SAMPLE_RATE / DF);
+  return 0;
+}
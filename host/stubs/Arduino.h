@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Just enough of the Teensy core for the decoders to build on a PC - see
+// ../main.cpp. Time and cycles come from the host.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#define DMAMEM
+#define FASTRUN
+#define PROGMEM
+
+#define HIGH 1
+#define LOW 0
+
+// Host CPU time, scaled to a nominal F_CPU_ACTUAL clock. Only good for
+// comparing one decoder with another, not for what a Teensy would take.
+extern uint32_t host_cycles(void);
+#define ARM_DWT_CYCCNT host_cycles()
+#define F_CPU_ACTUAL 600000000
+
+extern unsigned long millis(void);
+static inline void digitalWrite(int pin, int val) {}
+
+class HostSerial {
+public:
+  size_t print(const char *s);
+  size_t print(char c);
+  size_t println(const char *s = "");
+  size_t printf(const char *fmt, ...);
+};
+
+extern HostSerial Serial;
+
+#endif
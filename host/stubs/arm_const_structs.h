@@ -0,0 +1,10 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Included, but not used, by the decoders - see ../main.cpp
+
+#ifndef HOST_ARM_CONST_STRUCTS_H
+#define HOST_ARM_CONST_STRUCTS_H
+
+#include "arm_math.h"
+
+#endif
@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// The few CMSIS DSP bits the decoders use, in plain C - see ../main.cpp
+
+#ifndef HOST_ARM_MATH_H
+#define HOST_ARM_MATH_H
+
+#include <stdint.h>
+#include <math.h>
+
+typedef float float32_t;
+typedef int16_t q15_t;
+
+#define PI 3.14159265358979f
+
+struct arm_cfft_instance_f32 {
+  uint16_t fftLen;
+};
+
+static inline float32_t arm_sin_f32(float32_t x) { return sinf(x); }
+static inline float32_t arm_cos_f32(float32_t x) { return cosf(x); }
+
+#endif
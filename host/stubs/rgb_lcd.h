@@ -0,0 +1,8 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Included, but not used, by the decoders - see ../main.cpp
+
+#ifndef HOST_RGB_LCD_H
+#define HOST_RGB_LCD_H
+
+#endif
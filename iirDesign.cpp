@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// IIR bandpass design - see iirDesign.h
+//
+// We build the lowpass prototype poles (and zeros, for elliptic) in the
+// analog domain, with a passband edge of 1, then:
+//  - lowpass to bandpass transform, s -> (s^2 + w0^2) / (s.B)
+//  - bilinear transform to z, with the band edges pre-warped
+//  - pair each conjugate pole pair with the nearest zeros into a biquad
+//
+// The elliptic prototype uses the Landen transformation method from
+// S. J. Orfanidis, "Lecture Notes on Elliptic Filter Design".
+
+#include <Audio.h>
+#include <arm_math.h>
+#include <math.h>
+#include <complex>
+
+#include "global.h"
+#include "iirDesign.h"
+
+typedef std::complex<double> cplx;
+
+#define LANDEN_STEPS 7
+
+static const cplx J(0.0, 1.0);
+
+//---------------------------------------------------------------
+// Elliptic functions
+
+// Descending Landen sequence of moduli
+static void landen(double k, double v[LANDEN_STEPS]) {
+  for (int n = 0; n < LANDEN_STEPS; n++) {
+    double kp = sqrt(1.0 - k * k);
+    k = (1.0 - kp) / (1.0 + kp);
+    v[n] = k;
+  }
+}
+
+// cd(u.K, k), u normalised to the quarter period
+static cplx cde(cplx u, double k) {
+  double v[LANDEN_STEPS];
+  cplx w = std::cos(u * M_PI / 2.0);
+
+  landen(k, v);
+  for (int n = LANDEN_STEPS - 1; n >= 0; n--)
+    w = (1.0 + v[n]) * w / (1.0 + v[n] * w * w);
+  return w;
+}
+
+// sn(u.K, k)
+static cplx sne(cplx u, double k) {
+  double v[LANDEN_STEPS];
+  cplx w = std::sin(u * M_PI / 2.0);
+
+  landen(k, v);
+  for (int n = LANDEN_STEPS - 1; n >= 0; n--)
+    w = (1.0 + v[n]) * w / (1.0 + v[n] * w * w);
+  return w;
+}
+
+// Inverse of sne()
+static cplx asne(cplx w, double k) {
+  double v[LANDEN_STEPS];
+
+  landen(k, v);
+  for (int n = 0; n < LANDEN_STEPS; n++) {
+    double v1 = (n == 0) ? k : v[n - 1];
+    w = w / (1.0 + std::sqrt(1.0 - w * w * v1 * v1)) * 2.0 / (1.0 + v[n]);
+  }
+  return 1.0 - std::acos(w) * 2.0 / M_PI;
+}
+
+// Solve the degree equation for the selectivity, given the order and the
+// ripple ratio.
+static double ellipdeg(int n, double k1) {
+  double k1p = sqrt(1.0 - k1 * k1);
+  double kp = pow(k1p, n);
+
+  for (int i = 1; i <= n / 2; i++) {
+    double s = sne((2.0 * i - 1.0) / n, k1p).real();
+    kp *= s * s * s * s;
+  }
+  return sqrt(1.0 - kp * kp);
+}
+
+//---------------------------------------------------------------
+// Lowpass prototypes. Fill in the poles, and zeros, in the upper half plane
+// (plus any real pole), and return the gain at DC.
+
+static double butterworth_proto(int n, cplx *poles, int *np, cplx *zeros, int *nz) {
+  *np = 0;
+  *nz = 0;
+  for (int i = 1; i <= (n + 1) / 2; i++) {
+    double theta = (2.0 * i - 1.0) * M_PI / (2.0 * n);
+    poles[(*np)++] = cplx(-sin(theta), cos(theta));
+  }
+  return 1.0;
+}
+
+static double chebyshev_proto(int n, double ripple_db, cplx *poles, int *np, cplx *zeros, int *nz) {
+  double ep = sqrt(pow(10.0, ripple_db / 10.0) - 1.0);
+  double mu = asinh(1.0 / ep) / n;
+
+  *np = 0;
+  *nz = 0;
+  for (int i = 1; i <= (n + 1) / 2; i++) {
+    double theta = (2.0 * i - 1.0) * M_PI / (2.0 * n);
+    poles[(*np)++] = cplx(-sinh(mu) * sin(theta), cosh(mu) * cos(theta));
+  }
+  return (n & 1) ? 1.0 : 1.0 / sqrt(1.0 + ep * ep);
+}
+
+static double elliptic_proto(int n, double ripple_db, double atten, cplx *poles, int *np, cplx *zeros, int *nz) {
+  double ep = sqrt(pow(10.0, ripple_db / 10.0) - 1.0);
+  double es = sqrt(pow(10.0, atten / 10.0) - 1.0);
+  double k1 = ep / es;
+  double k = ellipdeg(n, k1);
+  double v0 = (asne(J / ep, k1) / (double)n).imag();
+
+  *np = 0;
+  *nz = 0;
+  for (int i = 1; i <= n / 2; i++) {
+    double u = (2.0 * i - 1.0) / n;
+    zeros[(*nz)++] = J / (k * cde(u, k).real());
+    poles[(*np)++] = J * cde(cplx(u, -v0), k);
+  }
+  if (n & 1) poles[(*np)++] = J * sne(cplx(0.0, v0), k);
+
+  return (n & 1) ? 1.0 : 1.0 / sqrt(1.0 + ep * ep);
+}
+
+//---------------------------------------------------------------
+
+// Both roots of s^2 - p.B.s + w0^2, which is where a prototype pole or zero p
+// lands after the bandpass transform. Hand back the one in the upper half plane.
+static cplx bp_transform(cplx p, double bw, double w0, bool conj_too, cplx *other) {
+  cplx d = std::sqrt(p * p * bw * bw - 4.0 * w0 * w0);
+  cplx s1 = (p * bw + d) / 2.0;
+  cplx s2 = (p * bw - d) / 2.0;
+
+  if (s1.imag() < s2.imag()) std::swap(s1, s2);
+  if (other) *other = conj_too ? std::conj(s2) : s2;
+  return s1;
+}
+
+static cplx bilinear(cplx s) {
+  return (1.0 + s) / (1.0 - s);
+}
+
+// |H(e^jw)| of one CMSIS ordered stage
+static double stage_gain(const float32_t *c, double w) {
+  cplx z1 = std::exp(-J * w);
+  cplx num = (double)c[0] + (double)c[1] * z1 + (double)c[2] * z1 * z1;
+  cplx den = 1.0 - (double)c[3] * z1 - (double)c[4] * z1 * z1;
+  return std::abs(num / den);
+}
+
+int designIIR(float32_t coeffs[], int order, int method, double fc1, double fc2,
+    double ripple_db, double atten, double samplerate) {
+  cplx proto_p[IIR_MAX_STAGES], proto_z[IIR_MAX_STAGES];
+  cplx poles[IIR_MAX_STAGES], zeros[IIR_MAX_STAGES];
+  bool zero_used[IIR_MAX_STAGES];
+  int n = order / 2, npp, npz, np = 0, nz = 0;
+  double wlo, whi, bw, w0, wc, h0;
+
+  if ((n < 1) || (n > IIR_MAX_STAGES)) return 0;
+  if ((fc1 <= 0.0) || (fc1 >= fc2) || (fc2 >= samplerate / 2.0)) return 0;
+
+  switch (method) {
+    case W_BUTTERWORTH:
+      h0 = butterworth_proto(n, proto_p, &npp, proto_z, &npz);
+      break;
+    case W_CHEBYSHEV:
+      h0 = chebyshev_proto(n, ripple_db, proto_p, &npp, proto_z, &npz);
+      break;
+    case W_ELLIPTIC:
+      h0 = elliptic_proto(n, ripple_db, atten, proto_p, &npp, proto_z, &npz);
+      break;
+    default:
+      return 0;
+  }
+
+  // Pre-warp the band edges for the bilinear transform
+  wlo = tan(M_PI * fc1 / samplerate);
+  whi = tan(M_PI * fc2 / samplerate);
+  bw = whi - wlo;
+  w0 = sqrt(wlo * whi);
+  wc = 2.0 * atan(w0);          //Where the prototype DC lands, in radians/sample
+
+  // Each upper prototype pole, and its conjugate, makes one upper bandpass pole.
+  // A real prototype pole makes a conjugate pair on its own.
+  for (int i = 0; i < npp; i++) {
+    cplx other;
+    poles[np++] = bilinear(bp_transform(proto_p[i], bw, w0, true, &other));
+    if (proto_p[i].imag() > 1e-9) poles[np++] = bilinear(other);
+  }
+  // Zeros on the j axis, which all land on the unit circle
+  for (int i = 0; i < npz; i++) {
+    cplx other;
+    zeros[nz++] = bilinear(bp_transform(proto_z[i], bw, w0, true, &other));
+    zeros[nz++] = bilinear(other);
+    zero_used[nz - 2] = zero_used[nz - 1] = false;
+  }
+
+  if (np != n) return 0;
+
+  for (int i = 0; i < n; i++) {
+    float32_t *c = &coeffs[i * 5];
+    cplx p = poles[i];
+    int best = -1;
+
+    // Nearest unused zero. Anything left over gets a zero at DC and Nyquist.
+    for (int j = 0; j < nz; j++) {
+      if (zero_used[j]) continue;
+      if ((best < 0) || (std::abs(zeros[j] - p) < std::abs(zeros[best] - p))) best = j;
+    }
+
+    if (best >= 0) {
+      zero_used[best] = true;
+      c[0] = 1.0;
+      c[1] = -2.0 * zeros[best].real();
+      c[2] = std::norm(zeros[best]);
+    } else {
+      c[0] = 1.0;
+      c[1] = 0.0;
+      c[2] = -1.0;
+    }
+
+    // CMSIS wants the feedback terms negated
+    c[3] = 2.0 * p.real();
+    c[4] = -std::norm(p);
+
+    // Unity gain for each stage at the centre, so no one stage gets too hot
+    double g = stage_gain(c, wc);
+    c[0] /= g;
+    c[1] /= g;
+    c[2] /= g;
+  }
+
+  // And then put the passband ripple back, so we sit in the ripple where
+  // the prototype says we should.
+  coeffs[0] *= h0;
+  coeffs[1] *= h0;
+  coeffs[2] *= h0;
+
+  if (DEBUG) Serial.printf("Designed IIR %d stages %f-%f\n", n, fc1, fc2);
+
+  return n;
+}
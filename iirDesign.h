@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// IIR bandpass design - Butterworth, Chebyshev (type I) and elliptic - into
+// a cascade of biquads for arm_biquad_cascade_df2T_f32().
+//
+// These run after decimation, so a narrow CW filter costs a few biquads per
+// decimated sample, rather than a couple of hundred FIR taps at the full rate.
+
+#ifndef IIRDESIGN_H
+#define IIRDESIGN_H
+
+#include <arm_math.h>
+
+// More 'window' types for the filterList table (see filterDesign.h).
+// For these the coeff field is the order of the bandpass - two per biquad.
+const int W_BUTTERWORTH = 6;
+const int W_CHEBYSHEV =   7;
+const int W_ELLIPTIC =    8;
+
+#define IS_IIR_WINDOW(w) (((w) >= W_BUTTERWORTH) && ((w) <= W_ELLIPTIC))
+
+// Most biquads we will build - an order 16 bandpass.
+#define IIR_MAX_STAGES 8
+
+// Design a bandpass of 'order' (even), passband fc1 to fc2 Hz, into coeffs[]
+// (5 per stage, in CMSIS df2T order: b0, b1, b2, a1, a2).
+// Chebyshev and elliptic use ripple_db of passband ripple, and elliptic
+// goes for atten dB in the stopband.
+// Returns the number of stages, or 0 if we cannot do it at this samplerate.
+extern int designIIR(float32_t coeffs[], int order, int method, double fc1, double fc2,
+  double ripple_db, double atten, double samplerate);
+
+#endif
@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+#include <Audio.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "dynamicFilters.h"
+#include "dspfilter.h"
+#include "filterDesign.h"
+#include "iirDesign.h"
+#include "iirFilter.h"
+
+#define IIR_FRAME_SIZE (AUDIO_BLOCK_SAMPLES * N_BLOCKS / DF)
+
+static arm_biquad_cascade_df2T_instance_f32 iir_inst[2];
+static float32_t iir_coeffs[2][IIR_MAX_STAGES * 5];
+static float32_t iir_state[2][IIR_MAX_STAGES * 2];
+
+static int iir_current = -1;    //Which instance we are listening to, -1 for none
+static int iir_previous = -1;   //and which we are fading out from
+static bool iir_fading = false;
+
+static float32_t iir_fade_buf[IIR_FRAME_SIZE];
+
+void iir_filter_start(const float32_t *coeffs, int stages) {
+  int next = (iir_current == 0) ? 1 : 0;
+
+  memcpy(iir_coeffs[next], coeffs, sizeof(float32_t) * 5 * stages);
+  //Zeros the state for us as well
+  arm_biquad_cascade_df2T_init_f32(&iir_inst[next], stages, iir_coeffs[next], iir_state[next]);
+
+  iir_previous = iir_current;
+  iir_current = next;
+  iir_fading = true;
+}
+
+void iir_filter_stop(void) {
+  if (iir_current < 0) return;
+
+  iir_previous = iir_current;
+  iir_current = -1;
+  iir_fading = true;
+}
+
+bool iir_filter_active(void) {
+  return (iir_current >= 0);
+}
+
+bool iir_filter_busy(void) {
+  return iir_fading;
+}
+
+void iir_filter_process(float32_t *buf, uint32_t blockSize) {
+  if (!iir_fading) {
+    if (iir_current >= 0) arm_biquad_cascade_df2T_f32(&iir_inst[iir_current], buf, buf, blockSize);
+    return;
+  }
+
+  // Run both the old and the new filter over this frame, and cross fade
+  // from one to the other. 'No filter' is just the input as is.
+  if (blockSize > IIR_FRAME_SIZE) blockSize = IIR_FRAME_SIZE;
+
+  if (iir_previous >= 0) arm_biquad_cascade_df2T_f32(&iir_inst[iir_previous], buf, iir_fade_buf, blockSize);
+  else memcpy(iir_fade_buf, buf, sizeof(float32_t) * blockSize);
+
+  if (iir_current >= 0) arm_biquad_cascade_df2T_f32(&iir_inst[iir_current], buf, buf, blockSize);
+
+  for (uint32_t i = 0; i < blockSize; i++) {
+    float32_t g = (float32_t)i / (float32_t)blockSize;
+    buf[i] = (buf[i] * g) + (iir_fade_buf[i] * (1.0 - g));
+  }
+
+  iir_fading = false;
+}
+
+void iir_filter_benchmark(void) {
+  static float32_t coeffs[IIR_MAX_STAGES * 5];
+  static float32_t state[IIR_MAX_STAGES * 2];
+  static float32_t fbuf[IIR_FRAME_SIZE];
+  static q15_t qin[AUDIO_BLOCK_SAMPLES * N_BLOCKS], qout[AUDIO_BLOCK_SAMPLES * N_BLOCKS];
+  static q15_t fir_state[NUM_COEFFICIENTS + AUDIO_BLOCK_SAMPLES];
+  static short fir_coeffs[NUM_COEFFICIENTS];
+  static float32_t fir_fcoeffs[NUM_COEFFICIENTS];
+  arm_biquad_cascade_df2T_instance_f32 iir;
+  arm_fir_instance_q15 fir;
+  const float32_t frame_cycles = (float32_t)F_CPU_ACTUAL * (AUDIO_BLOCK_SAMPLES * N_BLOCKS) / SAMPLE_RATE;
+  uint32_t cycles;
+  int stages, taps;
+
+  for (int i = 0; i < AUDIO_BLOCK_SAMPLES * N_BLOCKS; i++) qin[i] = (q15_t)(random(-16384, 16384));
+  for (int i = 0; i < IIR_FRAME_SIZE; i++) fbuf[i] = (float32_t)qin[i] / 32768.0;
+
+  Serial.println("Filter benchmark, cycles per frame - 250Hz wide CW filter:");
+
+  for (int method = W_BUTTERWORTH; method <= W_ELLIPTIC; method++) {
+    stages = designIIR(coeffs, 8, method, 575.0, 825.0, FILTER_DESIGN_RIPPLE_DB, 60.0, SAMPLE_RATE / DF);
+    if (stages == 0) continue;
+    arm_biquad_cascade_df2T_init_f32(&iir, stages, coeffs, state);
+
+    cycles = ARM_DWT_CYCCNT;
+    arm_biquad_cascade_df2T_f32(&iir, fbuf, fbuf, IIR_FRAME_SIZE);
+    cycles = ARM_DWT_CYCCNT - cycles;
+
+    Serial.printf(" IIR %d %d stages @%.0fHz: %u (%.2f%%)\n", method, stages, SAMPLE_RATE / DF,
+      (unsigned)cycles, cycles * 100.0 / frame_cycles);
+  }
+
+  // The FIR runs at the full rate, a block at a time, like AudioFilterFIR does.
+  for (int remez = 0; remez < 2; remez++) {
+    if (remez) {
+      taps = designFilter(fir_fcoeffs, NUM_COEFFICIENTS, ID_BANDPASS, W_REMEZ, 575.0, 825.0, 500.0, 50.0, SAMPLE_RATE);
+      arm_float_to_q15(fir_fcoeffs, fir_coeffs, taps);
+    } else {
+      taps = NUM_COEFFICIENTS;
+      audioFilter(fir_coeffs, taps, ID_BANDPASS, W_HAMMING, 575.0, 825.0);
+    }
+    if (taps == 0) continue;
+    arm_fir_init_q15(&fir, taps, fir_coeffs, fir_state, AUDIO_BLOCK_SAMPLES);
+
+    cycles = ARM_DWT_CYCCNT;
+    for (int i = 0; i < N_BLOCKS; i++)
+      arm_fir_fast_q15(&fir, &qin[i * AUDIO_BLOCK_SAMPLES], &qout[i * AUDIO_BLOCK_SAMPLES], AUDIO_BLOCK_SAMPLES);
+    cycles = ARM_DWT_CYCCNT - cycles;
+
+    Serial.printf(" FIR %s %d taps @%.0fHz: %u (%.2f%%)\n", remez ? "Remez" : "Hamming", taps, SAMPLE_RATE,
+      (unsigned)cycles, cycles * 100.0 / frame_cycles);
+  }
+}
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Runs the IIR user filter (see iirDesign.h) on the decimated float stream.
+//
+// Like the FIR path there are two sets of coefficients and state, so a new
+// filter can be faded in across one frame without clicking.
+
+#ifndef IIRFILTER_H
+#define IIRFILTER_H
+
+#include <arm_math.h>
+
+// Fade over to a new cascade of 'stages' biquads. Coefficients are copied.
+extern void iir_filter_start(const float32_t *coeffs, int stages);
+
+// Fade back out to no IIR filtering at all.
+extern void iir_filter_stop(void);
+
+extern bool iir_filter_active(void);
+
+// True until the last start/stop has been faded in by iir_filter_process()
+extern bool iir_filter_busy(void);
+
+// Filter the decimated frame, in place.
+extern void iir_filter_process(float32_t *buf, uint32_t blockSize);
+
+// Time the IIR cascade against the FIR filter it replaces, and print the
+// results out the serial port.
+extern void iir_filter_benchmark(void);
+
+#endif
@@ -27,41 +27,79 @@
 uint16_t fnr_level = 2; //1-3
 uint16_t fnra_level = 5; //4-6
 
-volatile float outwork_fn  = 0;
-static float buffer[MAX_FILTER_BUF];
+// The instances used by the main audio loop.
+fnr_instance fnr_state;
+fnra_instance fnra_state;
+
+void fnrFilter_init(fnr_instance *s)
+{
+  s->outwork = 0.0;
+}
+
+void fnrFilter_n_Average_init(fnra_instance *s)
+{
+  for (int i = 0; i < MAX_FILTER_BUF; i++) s->buffer[i] = 0.0;
+  s->sum = 0.0;
+  s->idx = 0;
+  s->len = 0;
+}
 
 // Variable noise filter (Exponential Smooting Moving Filter) : n: 3 (max) - 1 (min)
-float fnrFilter_n(float inwork, uint16_t n)
+void fnrFilter_n(fnr_instance *s, const float32_t *src, float32_t *dst, uint32_t blockSize, uint16_t n)
 {
+  float32_t coeff = 0.3;
+  float32_t outwork = s->outwork;   //Keep the history in a register for the loop
 
-	float coeff;
-	if (n==1) coeff = 0.5;
-	if (n==2) coeff = 0.3;
-	if (n==3) coeff = 0.1;
+  if (n==1) coeff = 0.5;
+  if (n==2) coeff = 0.3;
+  if (n==3) coeff = 0.1;
 
-    outwork_fn += (inwork - outwork_fn) * coeff;
-    return outwork_fn;
- }
+  for (uint32_t i = 0; i < blockSize; i++) {
+    outwork += (src[i] - outwork) * coeff;
+    dst[i] = outwork;
+  }
+
+  s->outwork = outwork;
+}
 
 // Variable noise filter (Average Smooting Moving Filter) : n: 6 (max) - 4 (min)
-float fnrFilter_n_Average(float inwork ,uint16_t n)
+void fnrFilter_n_Average(fnra_instance *s, const float32_t *src, float32_t *dst, uint32_t blockSize, uint16_t n)
 {
-  int idx_max_buf;
-  if (n==4) idx_max_buf = 8;
-	if (n==5) idx_max_buf = 16;
-	if (n==6) idx_max_buf = 24;
-
-	int i;
-  float out = 0;
-
-  for (i = (idx_max_buf-1); i > 0; i--)
-	{
-		buffer[i] = buffer[i-1];
-		out+=buffer[i];
-	}
-	buffer[0] = inwork;
-	out+=inwork;
-	out=(out/idx_max_buf)*0.8;
-
-  return out;
+  uint16_t len = 16;
+  float32_t scale;
+
+  if (n==4) len = 8;
+  if (n==5) len = 16;
+  if (n==6) len = 24;
+
+  // The ring always holds the last MAX_FILTER_BUF samples, so a change of
+  // window length only needs the sum re-adding over the new window.
+  if (len != s->len) {
+    s->len = len;
+    s->sum = 0.0;
+    for (uint16_t i = 1; i <= len; i++)
+      s->sum += s->buffer[(s->idx + MAX_FILTER_BUF - i) % MAX_FILTER_BUF];
+  }
+
+  scale = 0.8 / len;
+
+  for (uint32_t i = 0; i < blockSize; i++) {
+    // The sample dropping out of the window is 'len' samples back - read it
+    // before we overwrite its slot (they are the same slot at max length).
+    float32_t old = s->buffer[(s->idx + MAX_FILTER_BUF - len) % MAX_FILTER_BUF];
+
+    s->buffer[s->idx] = src[i];
+    s->sum += src[i] - old;
+
+    if (++s->idx == MAX_FILTER_BUF) {
+      s->idx = 0;
+      // Re-add the window from scratch once per lap of the ring, so float
+      // rounding in the running sum cannot build up over time.
+      s->sum = 0.0;
+      for (uint16_t j = MAX_FILTER_BUF - len; j < MAX_FILTER_BUF; j++)
+        s->sum += s->buffer[j];
+    }
+
+    dst[i] = s->sum * scale;
+  }
 }
@@ -26,11 +26,35 @@ extern uint16_t fnra_level; //4-6
 #define FNRA_LEVEL_MIN 4
 #define FNRA_LEVEL_MAX 6
 
-extern volatile float outwork_fn;
-float  fnrFilter_n(float inwork, uint16_t n);
-float  fnrFilter_n_Average(float inwork ,uint16_t n);
-
-
+// Both filters take a whole block of (decimated) samples per call, and keep
+// their history in an instance struct that is passed in, so more than one
+// of each can run without sharing state. fnr_state and fnra_state are the
+// ones the main audio path uses.
+
+// Exponential smoothing filter state
+typedef struct {
+  float32_t outwork;      // Last output - the smoothing history
+} fnr_instance;
+
+// Average smoothing filter state. The moving average is kept as a running
+// sum over a ring buffer, so the cost per sample does not depend on the
+// window length.
+typedef struct {
+  float32_t buffer[MAX_FILTER_BUF];   // Ring of the last 'len' input samples
+  float32_t sum;                      // Running sum of the samples in the ring
+  uint16_t idx;                       // Next slot to overwrite
+  uint16_t len;                       // Current window length (0 == not yet set up)
+} fnra_instance;
+
+extern fnr_instance fnr_state;
+extern fnra_instance fnra_state;
+
+void fnrFilter_init(fnr_instance *s);
+void fnrFilter_n_Average_init(fnra_instance *s);
+
+// Process blockSize samples from src into dst. src and dst may be the same buffer.
+void fnrFilter_n(fnr_instance *s, const float32_t *src, float32_t *dst, uint32_t blockSize, uint16_t n);
+void fnrFilter_n_Average(fnra_instance *s, const float32_t *src, float32_t *dst, uint32_t blockSize, uint16_t n);
 
 #endif /* FILTER_NOISE_REDUCTION_H_INCLUDED */
 
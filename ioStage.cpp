@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+#include <Audio.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "ioStage.h"
+
+static int32_t in_peak = 0;
+static uint64_t in_sumsq = 0;
+static uint32_t in_clips = 0;
+static uint32_t in_samples = 0;
+
+void io_input_block(const int16_t *src, float32_t *dst, uint32_t n) {
+  int32_t peak = in_peak;
+  uint64_t sumsq = 0;
+  uint32_t clips = 0;
+
+  for (uint32_t i = 0; i < n; i++) {
+    int32_t v = src[i];
+    int32_t a = (v < 0) ? -v : v;
+
+    if (a > peak) peak = a;
+    if (a >= IO_CLIP_LEVEL) clips++;
+    //Cannot overflow in 32 bits for one sample, so only widen for the sum
+    sumsq += (uint32_t)(v * v);
+    dst[i] = (float32_t)v * (1.0 / 32768.0);
+  }
+
+  in_peak = peak;
+  in_sumsq += sumsq;
+  in_clips += clips;
+  in_samples += n;
+}
+
+bool io_input_read(struct io_input_stats *s) {
+  if (in_samples == 0) return false;
+
+  s->peak = (float32_t)in_peak / 32768.0;
+  s->rms = sqrtf((float32_t)in_sumsq / (float32_t)in_samples) / 32768.0;
+  s->clips = in_clips;
+  s->samples = in_samples;
+
+  in_peak = 0;
+  in_sumsq = 0;
+  in_clips = 0;
+  in_samples = 0;
+  return true;
+}
+
+//---------------------------------------------------------------
+// Output
+
+// Coefficients laid out per phase, and reversed, so each output sample is a
+// straight run along both the phase coefficients and the input history.
+static float32_t out_coeffs[IO_INTERP_MAX_TAPS];
+static int out_factor = 1;
+static int out_phase_len = 0;
+static float32_t out_hist[IO_INTERP_MAX_TAPS + AUDIO_BLOCK_SAMPLES];
+
+static float32_t out_gain = 1.0, out_gain_target = 1.0;
+static float32_t out_gain_alpha;
+
+static int32_t out_peak = 0;
+static uint32_t out_clips = 0;
+static uint32_t out_samples = 0;
+
+bool io_output_init(const float32_t *coeffs, int ntaps, int factor) {
+  if ((factor < 1) || (ntaps % factor) || (ntaps > IO_INTERP_MAX_TAPS)) return false;
+
+  out_factor = factor;
+  out_phase_len = ntaps / factor;
+
+  for (int p = 0; p < factor; p++)
+    for (int j = 0; j < out_phase_len; j++)
+      out_coeffs[p * out_phase_len + j] = coeffs[p + (out_phase_len - 1 - j) * factor] * factor;
+
+  memset(out_hist, 0, sizeof(out_hist));
+
+  out_gain_alpha = 1.0 - expf(-1000.0 / (IO_GAIN_SMOOTH_MS * SAMPLE_RATE));
+  return true;
+}
+
+void io_output_gain(float32_t gain) {
+  out_gain_target = gain;
+}
+
+void io_output_block(const float32_t *src, int16_t *dst, uint32_t n) {
+  const uint32_t nin = n / out_factor;
+  const float32_t target = out_gain_target, alpha = out_gain_alpha;
+  float32_t gain = out_gain;
+  int32_t peak = out_peak;
+  uint32_t clips = 0;
+
+  //History from last time is already at the front
+  memcpy(&out_hist[out_phase_len - 1], src, sizeof(float32_t) * nin);
+
+  for (uint32_t i = 0; i < nin; i++) {
+    const float32_t *x = &out_hist[i];
+
+    for (int p = 0; p < out_factor; p++) {
+      const float32_t *c = &out_coeffs[p * out_phase_len];
+      float32_t acc = 0.0;
+      int32_t v;
+
+      for (int j = 0; j < out_phase_len; j++) acc += c[j] * x[j];
+
+      gain += (target - gain) * alpha;
+      acc *= gain * 32768.0;
+
+      if (acc >= 32767.0) {
+        v = 32767;
+        clips++;
+      } else if (acc <= -32768.0) {
+        v = -32768;
+        clips++;
+      } else {
+        v = (int32_t)acc;
+      }
+
+      if (v > peak) peak = v;
+      else if (-v > peak) peak = -v;
+
+      *dst++ = (int16_t)v;
+    }
+  }
+
+  memmove(out_hist, &out_hist[nin], sizeof(float32_t) * (out_phase_len - 1));
+
+  out_gain = gain;
+  out_peak = peak;
+  out_clips += clips;
+  out_samples += n;
+}
+
+bool io_output_read(struct io_output_stats *s) {
+  if (out_samples == 0) return false;
+
+  s->peak = (float32_t)out_peak / 32768.0;
+  s->clips = out_clips;
+  s->samples = out_samples;
+
+  out_peak = 0;
+  out_clips = 0;
+  out_samples = 0;
+  return true;
+}
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Fused input and output stages.
+//
+// One pass over each incoming block converts it to float, and at the same
+// time keeps the peak, the sum of squares for the RMS, and a count of
+// clipped samples - so we do not need separate analysers walking the same
+// data in the Audio library.
+//
+// On the way out, one pass interpolates back up to the full rate (with the
+// interpolation gain folded into the filter), applies the output gain,
+// smoothed per sample, notes the output peak and packs to q15 with
+// saturation, straight into the play queue buffer.
+
+#ifndef IOSTAGE_H
+#define IOSTAGE_H
+
+#include <arm_math.h>
+
+// A sample at or beyond this (either polarity) counts as clipped
+#define IO_CLIP_LEVEL 32767
+
+struct io_input_stats {
+  float32_t peak;       // 0 to 1.0
+  float32_t rms;        // 0 to 1.0
+  uint32_t clips;       // Clipped samples
+  uint32_t samples;     // Samples the above cover
+};
+
+// Convert n q15 samples from src to float in dst, and add them to the stats.
+extern void io_input_block(const int16_t *src, float32_t *dst, uint32_t n);
+
+// Hand back the stats for everything since the last call, and start afresh.
+// Returns false if no samples have come in since then.
+extern bool io_input_read(struct io_input_stats *s);
+
+// Most interpolation filter taps we can take
+#define IO_INTERP_MAX_TAPS 256
+
+// How quickly the output gain follows a change, per sample
+#define IO_GAIN_SMOOTH_MS 10
+
+struct io_output_stats {
+  float32_t peak;       // 0 to 1.0, after the gain
+  uint32_t clips;       // Samples we had to saturate
+  uint32_t samples;
+};
+
+// Set up the interpolator, from the ntaps coefficients of a lowpass at the
+// full rate, to interpolate by factor. ntaps must be a multiple of factor.
+// The factor gain gets folded into the coefficients.
+// Returns false if it cannot be done.
+extern bool io_output_init(const float32_t *coeffs, int ntaps, int factor);
+
+// Take n/factor decimated samples from src, and produce n q15 samples in dst.
+extern void io_output_block(const float32_t *src, int16_t *dst, uint32_t n);
+
+// Output gain we head towards.
+extern void io_output_gain(float32_t gain);
+
+extern bool io_output_read(struct io_output_stats *s);
+
+#endif
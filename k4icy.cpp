@@ -98,6 +98,8 @@
  *        make adjustments to the code.  The current setup is for a 20 x 4 LCD using I2C and I don't believe the decoder timing will handle higher
  *        dimensions but yoy're welcome to experiment.
  *    2 - used this text for testing input using LCWO's Convert Text to CW feature: ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-=,.?"':;!@$
+ *    3 - (DSPham) the moving averages, the Dot / Dash pair bootstrap and the WPM are now kept by the timing statistics
+ *        shared with the other decoders - see morseTiming.h
  *    
  *//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -108,32 +110,25 @@
 #include "global.h"
 #include "morseGen.h"
 #include "k4icy.h"
+#include "morseTable.h"
+#include "morseTiming.h"
 
 void morseDecode();
 
 /// SYSTEM VARIABLES ////////////////////
-bool toneOutput = true;         //  Allows for control of a sidetone
 int debounceFactor = 14;        //  Debouncing of input signal via minimal signal time duration in ms.  Default should be 15 ms and no less than 8
 bool keyLine = false;           // This flag denotes acknowledgement of a active input status on the Morse Key Input Pin
 
 /// TIMING VARIABLES ////////////////////
 unsigned long timeTrack = millis(); // Will be used as a time base for many events
 
-long thresholdGeometricMean = 139;  //  This with be the Geometric Mean between short and long pulse pairs  sqrt (s * l)
-long thresholdArithmeticMean = 160; //  This will be the Arithmetic Mean between short and long pulse pairs  (s + l) / 2
+static struct morse_timing timing; //  Dot, Dash and space averages, and the threshold between them - see morseTiming.h
 
 long keyLineNewEvent = 0;       // Record newest key-down timing
-long keyLinePriorEvent = 0;     // Prior key-down timing for comparison
-
-long shortEventHistogramList[10];
-long longEventHistogramList[10];
-long spaceEventHistogramList[10];
-int eventHistogramTrack = 0;
-int wpmHistogramTrack = 0;
 
 unsigned long keyLineDuration = 0;  // Key-Down duration
+unsigned long keyUpTime = 0;    // Key-Up moment, to time the space to the next key-down
 unsigned long spaceDuration = 0;  // Key-Up duration
-unsigned long oldSpaceDuration = 0; // Historical reference of Key-Up duration
 unsigned long spaceDurationReference = 0; // Key-Up start moment
 
 float wordSpaceTiming = 3.0;    // * threshold... usually 7 units typical
@@ -141,42 +136,31 @@ unsigned long wordSpaceDuration = 0;  // Key-Up duration
 unsigned long wordSpaceDurationReference = 0; // Key-Up start moment
 
 /// DECODE VARIABLES ////////////////////
-float compareFactor = 2.0;      //  This factor determines the ratio threshold for comparing 'dahs' to 'dits' - assuming arithmetic mean of 3:1
 bool characterStep = false;     // Lock-step one character at a time for decoding
-char elementSequence[10];       //  This string will hold the 'dahs' and 'dits' to decode
-int elementSequenceTrack = 0;   //  Index into the string
-byte decodeChar = 0;            //  Decoded character from code element sequence lookup table
-String decodeProSign = "";      //  Decoded/detected multiple-letter procedural signs can be passed via this variable
-int decodeProSignLength;        //  This is useful when printing any prosigns
+int elementNumber = MORSE_START; //  The 'dahs' and 'dits' so far, as an element number - see morseTable.h
 bool wordStep = false;          // Add one blank space to display after word space duration has been met
 
-int oldWPM = 0;
-int WPM = 0;                    //  Words Per Minute to display
-int WPMHistogramList[20];
-int WPMHistogramTrack = 0;
-
 /// System Setup /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 void k4icy_setup()
 {
-  // preset moving averages  (15 wpm default)
-  for (int i = 0; i < 10; i++) {
-    shortEventHistogramList[i] = 80;
-    longEventHistogramList[i] = 240;
-    spaceEventHistogramList[i] = 80;
-  }
-  for (int i = 0; i < 20; i++) {
-    WPMHistogramList[i] = 15;
-  }
+  // preset averages  (15 wpm default)
+  morse_timing_init(&timing, MORSE_TIMING_DIT_START_MS);
+  keyLine = false;
+  keyUpTime = 0;
+  elementNumber = MORSE_START;
+  characterStep = false;
+  wordStep = false;
 }
 
 ////////////////////////////////// Operation //////////////////////////////////////////////////////////////////////////////////////
 
 /// When the Key is Down - or There is a Signal ////////////////////////////////////////
-void k4icy_keyDown()
+void k4icy_keyDown(unsigned long now)
 {
-  timeTrack = millis();
+  timeTrack = now;
 
   if (keyLine == false) {       // do the following only once per key-down event
+    if (keyUpTime) morse_timing_space(&timing, timeTrack - keyUpTime);  // roll the space into its average
     keyLineDuration = timeTrack;  // update duration
     wordSpaceDurationReference = timeTrack; // create starting point to measure for word space (typically 7 dits long)
     keyLine = true;
@@ -184,239 +168,47 @@ void k4icy_keyDown()
 }                               //end of key down
 
 /// When the Key is Up - or There is Not a Signal ///////////////////////////////////
-void k4icy_keyUp()
+void k4icy_keyUp(unsigned long now)
 {
-  timeTrack = millis();
+  timeTrack = now;
 
   ///  Allow for Time to Debounce the Signal //////////////////////////////////////
   if (timeTrack >= (keyLineDuration + debounceFactor) && keyLine) {
     keyLine = false;            // only allow for this section once per detected key-up
-    keyLinePriorEvent = keyLineNewEvent;  //  Create history of last signal duration event to compare to new one
     keyLineNewEvent = timeTrack - keyLineDuration;  // Get current event duration
+    keyUpTime = timeTrack;
 
-    ///  IF the Current Duration Event Compared to the Previous Event appears to be a Dot / Dash pair [ roughly (>2):1 ] /////////////////////////
-    if ((keyLineNewEvent >= keyLinePriorEvent * compareFactor
-         && oldSpaceDuration <= keyLinePriorEvent * compareFactor)
-        || (keyLinePriorEvent >= keyLineNewEvent * compareFactor
-            && oldSpaceDuration <= keyLineNewEvent * compareFactor)) {
-
-      /// Find out which one is the Dot and which is the Dash and roll them into a moving average of each /////////////////////////////////////
-      if (keyLineNewEvent >= keyLinePriorEvent) {
-        longEventHistogramList[eventHistogramTrack] = keyLineNewEvent;
-        shortEventHistogramList[eventHistogramTrack] = keyLinePriorEvent;
-      } else {
-        longEventHistogramList[eventHistogramTrack] = keyLinePriorEvent;
-        shortEventHistogramList[eventHistogramTrack] = keyLineNewEvent;
-      }
-
-      /// Keep a moving average detected dot/dash pairs ////////////////////////
-      long longEventAverage =
-          longEventHistogramList[0] +
-          longEventHistogramList[1] +
-          longEventHistogramList[2] +
-          longEventHistogramList[3] + longEventHistogramList[4];
-      longEventAverage +=
-          longEventHistogramList[5] +
-          longEventHistogramList[6] +
-          longEventHistogramList[7] +
-          longEventHistogramList[8] + longEventHistogramList[9];
-      longEventAverage /= 10;
-
-      long shortEventAverage =
-          shortEventHistogramList[0] +
-          shortEventHistogramList[1] +
-          shortEventHistogramList[2] +
-          shortEventHistogramList[3] + shortEventHistogramList[4];
-      shortEventAverage +=
-          shortEventHistogramList[5] +
-          shortEventHistogramList[6] +
-          shortEventHistogramList[7] +
-          shortEventHistogramList[8] + shortEventHistogramList[9];
-      shortEventAverage /= 10;
-
-      /// Find threshold means /////////////////////////
-      thresholdGeometricMean = sqrt(shortEventAverage * longEventAverage);
-      // thresholdArithmeticMean = (shortEventAverage + longEventAverage) / 2 ;
-
-      /// Keep a moving average of the intra-element space duration
-      spaceEventHistogramList[eventHistogramTrack] = oldSpaceDuration;
-
-      long spaceEventAverage =
-          spaceEventHistogramList[0] +
-          spaceEventHistogramList[1] +
-          spaceEventHistogramList[2] +
-          spaceEventHistogramList[3] + spaceEventHistogramList[4];
-      spaceEventAverage +=
-          spaceEventHistogramList[5] +
-          spaceEventHistogramList[6] +
-          spaceEventHistogramList[7] +
-          spaceEventHistogramList[8] + spaceEventHistogramList[9];
-      spaceEventAverage /= 10;
-
-      /// Bootstrap threshold values - - - If any are below or above known Dot/Dash pair ranges then move them instantly
-      if (thresholdGeometricMean < shortEventHistogramList[eventHistogramTrack]
-          || thresholdGeometricMean >
-          longEventHistogramList[eventHistogramTrack]) {
-
-        thresholdGeometricMean =
-            sqrt(shortEventHistogramList
-                 [eventHistogramTrack] *
-                 longEventHistogramList[eventHistogramTrack]);
-
-        longEventHistogramList[0] = longEventHistogramList[eventHistogramTrack];
-        longEventHistogramList[1] = longEventHistogramList[eventHistogramTrack];
-        longEventHistogramList[2] = longEventHistogramList[eventHistogramTrack];
-        longEventHistogramList[3] = longEventHistogramList[eventHistogramTrack];
-        longEventHistogramList[4] = longEventHistogramList[eventHistogramTrack];
-        longEventHistogramList[5] = longEventHistogramList[eventHistogramTrack];
-        longEventHistogramList[6] = longEventHistogramList[eventHistogramTrack];
-        longEventHistogramList[7] = longEventHistogramList[eventHistogramTrack];
-        longEventHistogramList[8] = longEventHistogramList[eventHistogramTrack];
-        longEventHistogramList[9] = longEventHistogramList[eventHistogramTrack];
-
-        shortEventHistogramList[0] =
-            shortEventHistogramList[eventHistogramTrack];
-        shortEventHistogramList[1] =
-            shortEventHistogramList[eventHistogramTrack];
-        shortEventHistogramList[2] =
-            shortEventHistogramList[eventHistogramTrack];
-        shortEventHistogramList[3] =
-            shortEventHistogramList[eventHistogramTrack];
-        shortEventHistogramList[4] =
-            shortEventHistogramList[eventHistogramTrack];
-        shortEventHistogramList[5] =
-            shortEventHistogramList[eventHistogramTrack];
-        shortEventHistogramList[6] =
-            shortEventHistogramList[eventHistogramTrack];
-        shortEventHistogramList[7] =
-            shortEventHistogramList[eventHistogramTrack];
-        shortEventHistogramList[8] =
-            shortEventHistogramList[eventHistogramTrack];
-        shortEventHistogramList[9] =
-            shortEventHistogramList[eventHistogramTrack];
-
-        longEventAverage = longEventHistogramList[eventHistogramTrack];
-        shortEventAverage = shortEventHistogramList[eventHistogramTrack];
-
-        WPMHistogramList[wpmHistogramTrack] =
-            (6000 /
-             (longEventHistogramList
-              [eventHistogramTrack] +
-              shortEventHistogramList[eventHistogramTrack] + oldSpaceDuration));
-        WPMHistogramList[0] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[1] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[2] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[3] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[4] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[5] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[6] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[7] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[8] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[9] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[10] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[11] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[12] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[13] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[14] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[15] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[16] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[17] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[18] = WPMHistogramList[wpmHistogramTrack];
-        WPMHistogramList[19] = WPMHistogramList[wpmHistogramTrack];
-
-      }
-      /// we will now calculate the WPM... ////////////////////////////////////////////
-      oldWPM = WPM;             // used to see when WPM has changed to save on LCD upload/refresh time
-
-      //          WPM = ( 6000 / ( longEventAverage + shortEventAverage + spaceEventAverage ) ) * 1.06 ;  // use this instead for faster WPM result
-      ///*         
-      WPMHistogramList[wpmHistogramTrack] = (6000 / (longEventAverage + shortEventAverage + spaceEventAverage));  // use this instead if WPM result is too jittery
-      //
-      //
-      WPM = 20 + WPMHistogramList[0] + WPMHistogramList[1] + WPMHistogramList[2] + WPMHistogramList[3] + WPMHistogramList[4]; // 
-      WPM += WPMHistogramList[5] + WPMHistogramList[6] + WPMHistogramList[7] + WPMHistogramList[8] + WPMHistogramList[9]; //
-      WPM += WPMHistogramList[10] + WPMHistogramList[11] + WPMHistogramList[12] + WPMHistogramList[13] + WPMHistogramList[14];  //
-      WPM += WPMHistogramList[15] + WPMHistogramList[16] + WPMHistogramList[17] + WPMHistogramList[18] + WPMHistogramList[19];  //
-      WPM /= 19.05;
-      //WPM /= 20 ;
-      //WPM *= 1.05 ;
-      //*/          
-
-      /// set index to build up further moving averages ////////////////
-      eventHistogramTrack++;
-      if (eventHistogramTrack > 9) {
-        eventHistogramTrack = 0;
-      }                         // reset index if needed
-
-      wpmHistogramTrack++;
-      if (wpmHistogramTrack > 19) {
-        wpmHistogramTrack = 0;
-      }                         // reset index if needed
-    }
     /// Reset space durations - in Key-Up state ///////////
     spaceDurationReference = timeTrack;
     wordSpaceDurationReference = timeTrack;
 
-    /// Classify and add most likely Dots or Dashes to a string for eventual character decoding
-    if (elementSequenceTrack + 2 <= sizeof(elementSequence)) {
-      if (keyLineNewEvent <= thresholdGeometricMean) {
-        elementSequence[elementSequenceTrack] = '.';
-        characterStep = true;
-        wordStep = true;
-      } else {
-        elementSequence[elementSequenceTrack] = '-';
-        characterStep = true;
-        wordStep = true;
-      }
-      elementSequenceTrack++;
-      elementSequence[elementSequenceTrack] = '\0';
-    } else {
-      //We've run out of sequence buffer - nominally we should thus mark this as a bad character,
-      //drop it, and move on... but, for now, just stop filling the buffer and let it
-      // 'naturally die'
-    }
+    /// Classify and add most likely Dots or Dashes to the element number for eventual character decoding,
+    /// and roll them into the averages - a Dot / Dash pair the threshold does not split moves it instantly
+    /// (once it is too long for any character it stays that way, and decodes as an error)
+    elementNumber = morse_append(elementNumber, morse_timing_mark(&timing, keyLineNewEvent));
+    characterStep = true;
+    wordStep = true;
   }
   /// Keep track of Key-Up space timing
-  oldSpaceDuration = spaceDuration;
   spaceDuration = timeTrack - spaceDurationReference;
 
   /// DECODE collected string of elements  /////////////////////////////////////////
 
   // check to see if inter-element space duration threshold has been exceeded - then decode
   // it is assumed that the intra-space is longer than a Dot but shorter than a Dash
-  //if (spaceDuration >= thresholdArithmeticMean) {    // using the Arithmetic Mean seems more stable
-  if (spaceDuration >= thresholdGeometricMean) {  // but using the Geometric Mean seems more accurate
+  if (spaceDuration >= morse_timing_threshold(&timing)) {  // using the Geometric Mean seems more accurate
     spaceDurationReference = timeTrack; // Key-Up space reset
 
     if (characterStep) {
-      morseDecode();            // decode element sequence string
-
-      if (decodeChar != 7) {
-        morsePrint(decodeChar);
-      } else {
-        decodeProSignLength = decodeProSign.length(); // get the length of the prosign if used
-
-        if (decodeProSignLength > 0) {
-          for (int i = 0; i < decodeProSignLength; i++) { // scan through the prosign string...
-            morsePrint(decodeProSign.charAt(i));
-          }
-
-          morsePrint(163);
-        } else {
-          morsePrint(decodeChar);
-        }
-      }
-
-      decodeChar = 0;
-      elementSequence[0] = '\0';  // clear memory of code elements
-      elementSequenceTrack = 0;
+      morseDecode();            // decode element sequence
+      elementNumber = MORSE_START;  // clear memory of code elements
     }
     characterStep = false;
   }
   /// Keep track of Key-Up timing and see if a word space is required
   wordSpaceDuration = timeTrack - wordSpaceDurationReference;
 
-  if (wordSpaceDuration >= thresholdGeometricMean * wordSpaceTiming) {
+  if (wordSpaceDuration >= morse_timing_threshold(&timing) * wordSpaceTiming) {
     wordSpaceDurationReference = timeTrack; // word space reset
 
     if (wordStep) {
@@ -429,245 +221,22 @@ void k4icy_keyUp()
 
 /// Secret Decoder Ring ///////////////////////////////////
 void morseDecode()
-{                               //  Here, we check the collected elements against our list to decode for the matching character
-  decodeChar = 0xff;             //Unkown char. (changed from 0x7 special char in original code, as we already use that) 0xff is a solid 'block' on 2x16 charset
-  decodeProSign = "";
-
-  //Serial.println(elementSequence);
-  if (strcmp(elementSequence, ".-") == 0) {
-    decodeChar = 65;
-  }                             // A    Letters
-  if (strcmp(elementSequence, "-...") == 0) {
-    decodeChar = 66;
-  }                             // B
-  if (strcmp(elementSequence, "-.-.") == 0) {
-    decodeChar = 67;
-  }                             // C
-  if (strcmp(elementSequence, "-..") == 0) {
-    decodeChar = 68;
-  }                             // D
-  if (strcmp(elementSequence, ".") == 0) {
-    decodeChar = 69;
-  }                             // E
-  if (strcmp(elementSequence, "..-.") == 0) {
-    decodeChar = 70;
-  }                             // F
-  if (strcmp(elementSequence, "--.") == 0) {
-    decodeChar = 71;
-  }                             // G
-  if (strcmp(elementSequence, "....") == 0) {
-    decodeChar = 72;
-  }                             // H
-  if (strcmp(elementSequence, "..") == 0) {
-    decodeChar = 73;
-  }                             // I
-  if (strcmp(elementSequence, ".---") == 0) {
-    decodeChar = 74;
-  }                             // J
-  if (strcmp(elementSequence, "-.-") == 0) {
-    decodeChar = 75;
-  }                             // K
-  if (strcmp(elementSequence, ".-..") == 0) {
-    decodeChar = 76;
-  }                             // L
-  if (strcmp(elementSequence, "--") == 0) {
-    decodeChar = 77;
-  }                             // M
-  if (strcmp(elementSequence, "-.") == 0) {
-    decodeChar = 78;
-  }                             // N
-  if (strcmp(elementSequence, "---") == 0) {
-    decodeChar = 79;
-  }                             // O
-  if (strcmp(elementSequence, ".--.") == 0) {
-    decodeChar = 80;
-  }                             // P
-  if (strcmp(elementSequence, "--.-") == 0) {
-    decodeChar = 81;
-  }                             // Q
-  if (strcmp(elementSequence, ".-.") == 0) {
-    decodeChar = 82;
-  }                             // R
-  if (strcmp(elementSequence, "...") == 0) {
-    decodeChar = 83;
-  }                             // S
-  if (strcmp(elementSequence, "-") == 0) {
-    decodeChar = 84;
-  }                             // T
-  if (strcmp(elementSequence, "..-") == 0) {
-    decodeChar = 85;
-  }                             // U
-  if (strcmp(elementSequence, "...-") == 0) {
-    decodeChar = 86;
-  }                             // V
-  if (strcmp(elementSequence, ".--") == 0) {
-    decodeChar = 87;
-  }                             // W
-  if (strcmp(elementSequence, "-..-") == 0) {
-    decodeChar = 88;
-  }                             // X
-  if (strcmp(elementSequence, "-.--") == 0) {
-    decodeChar = 89;
-  }                             // Y
-  if (strcmp(elementSequence, "--..") == 0) {
-    decodeChar = 90;
-  }                             // Z
-
-  if (strcmp(elementSequence, ".----") == 0) {
-    decodeChar = 49;
-  }                             // 1    Numbers
-  if (strcmp(elementSequence, "..---") == 0) {
-    decodeChar = 50;
-  }                             // 2
-  if (strcmp(elementSequence, "...--") == 0) {
-    decodeChar = 51;
-  }                             // 3
-  if (strcmp(elementSequence, "....-") == 0) {
-    decodeChar = 52;
-  }                             // 4
-  if (strcmp(elementSequence, ".....") == 0) {
-    decodeChar = 53;
-  }                             // 5
-  if (strcmp(elementSequence, "-....") == 0) {
-    decodeChar = 54;
-  }                             // 6
-  if (strcmp(elementSequence, "--...") == 0) {
-    decodeChar = 55;
-  }                             // 7
-  if (strcmp(elementSequence, "---..") == 0) {
-    decodeChar = 56;
-  }                             // 8
-  if (strcmp(elementSequence, "----.") == 0) {
-    decodeChar = 57;
-  }                             // 9
-  if (strcmp(elementSequence, "-----") == 0) {
-    decodeChar = 48;
-  }                             // 0
+{                               //  Here, we look the collected elements up in the shared table to decode the matching character
+  const char *text = morse_text(elementNumber);
 
-  if (strcmp(elementSequence, "-.-.--") == 0) {
-    decodeChar = 33;
-  }                             // !    Punctuation
-  if (strcmp(elementSequence, "..--.") == 0) {
-    decodeChar = 33;
-  }                             // !
-  if (strcmp(elementSequence, ".-..-.") == 0) {
-    decodeChar = 34;
-  }                             // "
-  if (strcmp(elementSequence, "...-..-") == 0) {
-    decodeChar = 36;
-  }                             // $
-  //if (strcmp(elementSequence,".-...") == 0)   { decodeChar = 38; }  // &
-  if (strcmp(elementSequence, ".----.") == 0) {
-    decodeChar = 39;
-  }                             // '
-  //if (strcmp(elementSequence,"-.--.") == 0)   { decodeChar = 40; }  // (
-  //if (strcmp(elementSequence,"-.--.-") == 0)  { decodeChar = 41; }  // )
-  //if (strcmp(elementSequence,".-.-.") == 0)   { decodeChar = 43; }  // +
-  if (strcmp(elementSequence, "--..--") == 0) {
-    decodeChar = 44;
-  }                             // ,
-  if (strcmp(elementSequence, "-....-") == 0) {
-    decodeChar = 45;
-  }                             // -
-  if (strcmp(elementSequence, ".-.-.-") == 0) {
-    decodeChar = 46;
-  }                             // .
-  if (strcmp(elementSequence, "-..-.") == 0) {
-    decodeChar = 47;
-  }                             // /
-  if (strcmp(elementSequence, "---...") == 0) {
-    decodeChar = 58;
-  }                             // :
-  if (strcmp(elementSequence, "-.-.-.") == 0) {
-    decodeChar = 59;
-  }                             // ;
-  if (strcmp(elementSequence,"-...-") == 0) {
-    decodeChar = 61;
-  }                             // = (Pause, BT)
-  if (strcmp(elementSequence, "..--..") == 0) {
-    decodeChar = 63;
-  }                             // ?
-  if (strcmp(elementSequence, ".--.-.") == 0) {
-    decodeChar = 64;
-  }                             // @
-  if (strcmp(elementSequence, "..--.-") == 0) {
-    decodeChar = 95;
-  }                             // _
-
-  //Graham - sorry, no space for the special chars on our
-  //display - we use them for other things already.
-  //Just have to replace them with their nearest non-special
-  //equivalent...
-  if (strcmp(elementSequence, ".-.-") == 0) {
-    decodeChar = 'A';
-  }                             // Ä    Special
-  if (strcmp(elementSequence, ".--.-") == 0) {
-    decodeChar = 'A';
-  }                             // Á
-  //if (strcmp(elementSequence,".-.-") == 0)  { decodeChar = 2; }  // Æ
-  if (strcmp(elementSequence, "-.-..") == 0) {
-    decodeChar = 'C';
-  }                             // Ç
-  if (strcmp(elementSequence, "..-..") == 0) {
-    decodeChar = 'E';
-  }                             // É
-  if (strcmp(elementSequence, "---.") == 0) {
-    decodeChar = 'O';
-  }                             // Ö
-  if (strcmp(elementSequence, "..--") == 0) {
-    decodeChar = 'U';
-  }                             // Ü
-  if (strcmp(elementSequence, "--.--") == 0) {
-    decodeChar = 'N';
-  }                             // Ñ
-
-  //if (strcmp(elementSequence,".-.-") == 0)    { decodeProSign = "AA"; }   // Prosigns   (New Line)
-  if (strcmp(elementSequence, ".-.-.") == 0) {
-    decodeProSign = "AR";
-  }                             //            (End of Message)
-  if (strcmp(elementSequence, ".-...") == 0) {
-    decodeProSign = "AS";
-  }                             //            (Wait)
-  if (strcmp(elementSequence, "-...-.-") == 0) {
-    decodeProSign = "BK";
-  }                             //            (Break)
-  if (strcmp(elementSequence, "-...-") == 0) {
-    decodeProSign = "BT";
-  }                             //            (Pause, New Paragraph)
-  if (strcmp(elementSequence, "-.-..-..") == 0) {
-    decodeProSign = "CL";
-  }                             //            (Clear, Going Off Air)
-  if (strcmp(elementSequence, "-.-.-") == 0) {
-    decodeProSign = "CT";
-  }                             //            (Start Copying)
-  if (strcmp(elementSequence, "-.--.") == 0) {
-    decodeProSign = "KN";
-  }                             //            (Invite Specific Station Only)
-  if (strcmp(elementSequence, "...-.-") == 0) {
-    decodeProSign = "SK";
-  }                             //            (End of Transmission)
-  if (strcmp(elementSequence, "...-.") == 0) {
-    decodeProSign = "SN";
-  }                             //            (Understood)
-  if (strcmp(elementSequence, "...---...") == 0) {
-    decodeProSign = "SOS";
-  }                             //            (SOS)
-  if (strcmp(elementSequence, "-.-.--.-") == 0) {
-    decodeProSign = "CQ";
-  }                             //          (Invitation)
-  if (strcmp(elementSequence, "........") == 0) {
-    decodeProSign = "err";
-  }                             //          (Error)
+  if (!text) {
+    morsePrint(0xff);           //Unkown char. (changed from 0x7 special char in original code, as we already use that) 0xff is a solid 'block' on 2x16 charset
+    return;
+  }
 
-  if (strcmp(elementSequence, "-..-..-") == 0) {
-    decodeProSign = "Speaker";
-    toneOutput = !toneOutput;
-  }                             //  Control to toggle the speaker
+  while (*text) {               // print the character, or scan through the prosign
+    morsePrint(*text++);
+  }
 }
 
 int k4icy_getWPM()
 {
-  return WPM;
+  return morse_timing_wpm(&timing);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1,5 +1,6 @@
 
 extern void k4icy_setup();
-extern void k4icy_keyUp();
-extern void k4icy_keyDown();
+// now is the time of the key state, in ms
+extern void k4icy_keyUp(unsigned long now);
+extern void k4icy_keyDown(unsigned long now);
 extern int k4icy_getWPM();
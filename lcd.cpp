@@ -3,10 +3,15 @@
 #include <arm_math.h>
 #include "lcd.h"
 #include "global.h"
+#include "governor.h"
+#include "pitchTrack.h"
 
 #include "morseDecode.h"
 #include "k4icy.h"
 #include "tf3lj_dec.h"
+#include "skimmer.h"
+#include "ensemble.h"
+#include "morseHmm.h"
 
 rgb_lcd lcd;
 
@@ -248,7 +253,11 @@ CPU is updated in the main loop.
       case 4:   //FM
         buf[1] = 'F';
         break;
-  
+
+      case 5:   //CW IIR
+        buf[1] = 'c';
+        break;
+
       default:
         buf[1] = '#';
         break;
@@ -276,6 +285,10 @@ CPU is updated in the main loop.
       case AGC_MODE_SG5K:
         buf[4] = '5';
         break;
+
+      case AGC_MODE_SW:
+        buf[4] = 'S';
+        break;
         
       default:
         buf[4] = '#';
@@ -352,8 +365,8 @@ CPU is updated in the main loop.
     break;
   }
 
-  //Spacer
-  buf[9] = ' ';
+  //Governor - shows how many rungs we have had to shed, if any
+  buf[9] = governor_marker();
 
   //CPU date lives in buf[10-12] - is filled out (overwritten) in main loop.
   buf[10] = ' ';
@@ -363,16 +376,28 @@ CPU is updated in the main loop.
 
   //Decoder speeds and things
   if (decoder_mode == DECODER_MORSE) {
-    buf[13] = 0x07; //The special morse tuning char
+    buf[13] = pitch_track_marker(); //The special morse tuning char, or the pitch lock state
     sprintf(&buf[14], "%2d", morseWPM() );
   } else
   if (decoder_mode == DECODER_MORSE_K4ICY) {
-    buf[13] = 0x07; //The special morse tuning char
+    buf[13] = pitch_track_marker(); //The special morse tuning char, or the pitch lock state
     sprintf(&buf[14], "%2d", k4icy_getWPM() );
   } else
   if (decoder_mode == DECODER_MORSE_TF3LJ) {
-    buf[13] = 0x07; //The special morse tuning char
+    buf[13] = pitch_track_marker(); //The special morse tuning char, or the pitch lock state
     sprintf(&buf[14], "%2d", tf3lj_getWPM() );
+  } else
+  if (decoder_mode == DECODER_MORSE_HMM) {
+    buf[13] = pitch_track_marker(); //The special morse tuning char, or the pitch lock state
+    sprintf(&buf[14], "%2d", hmm_wpm() );
+  } else
+  if (decoder_mode == DECODER_ENSEMBLE) {
+    buf[13] = 'E';  //Ensemble, and how much they are agreeing
+    sprintf(&buf[14], "%2d", (int)(ensemble_confidence() * 99.0) );
+  } else
+  if (decoder_mode == DECODER_SKIMMER) {
+    buf[13] = 'K';  //sKimmer, and how many channels it has going
+    sprintf(&buf[14], "%2d", skimmer_active() );
   } else {
     //spacer
     buf[13] = ' ';
@@ -15,6 +15,8 @@
 #include "morseGen.h"
 #include "dynamicFilters.h"
 #include "dspfilter.h"
+#include "filterCache.h"
+#include "agc.h"
 #include "lcd.h"
 #include "settings.h"
 
@@ -102,10 +104,31 @@ CHOOSE(decoder_mode,DecoderModeMenu,"Dcdr Mode",doNothing,noEvent,noStyle
   ,VALUE("Morse",DECODER_MORSE,doNothing,noEvent)
   ,VALUE("K4ICY",DECODER_MORSE_K4ICY,doNothing,noEvent)
   ,VALUE("TF3LJ",DECODER_MORSE_TF3LJ,doNothing,noEvent)
+  ,VALUE("HMM",DECODER_MORSE_HMM,doNothing,noEvent)
+  ,VALUE("Skimmer",DECODER_SKIMMER,doNothing,noEvent)
+  ,VALUE("Vote",DECODER_ENSEMBLE,doNothing,noEvent)
+);
+
+CHOOSE(pitch_track,PitchTrackMenu,"Pitch Trk",doNothing,noEvent,noStyle
+  ,VALUE("Off",0,doNothing,noEvent)
+  ,VALUE("On",1,doNothing,noEvent)
+);
+
+CHOOSE(key_source,KeySourceMenu,"Key src",doNothing,noEvent,noStyle
+  ,VALUE("Envlp",KEY_SOURCE_ENVELOPE,doNothing,noEvent)
+  ,VALUE("Legacy",KEY_SOURCE_LEGACY,doNothing,noEvent)
+);
+
+CHOOSE(text_tap,TextTapMenu,"USB txt",doNothing,noEvent,noStyle
+  ,VALUE("Off",TEXT_TAP_OFF,doNothing,noEvent)
+  ,VALUE("On",TEXT_TAP_ON,doNothing,noEvent)
 );
 
 MENU(DecoderTweaksMenu, "Dcdr tweak", Menu::doNothing, Menu::noEvent, Menu::wrapStyle
   ,FIELD(morse_frequency,"CW Freq","",1,1000,10,1,morseInit,enterEvent | exitEvent | updateEvent,noStyle)
+  ,SUBMENU(PitchTrackMenu)
+  ,SUBMENU(KeySourceMenu)
+  ,SUBMENU(TextTapMenu)
   ,FIELD(morse_threshold,"CW Tsh","",0,1,0.01,0.0,morseInit,enterEvent | exitEvent | updateEvent,noStyle)
   ,FIELD(morse_cycles,"CW cyc","",1,100,1.0,0.0,morseInit,enterEvent | exitEvent | updateEvent,noStyle)
   ,EXIT("<Back")
@@ -118,47 +141,15 @@ MENU(DecoderMenu, "Decoder menu", Menu::doNothing, Menu::noEvent, Menu::wrapStyl
 );
 
 int current_filter_mode = 0;
+int fir_path = FIR_PATH_FLOAT;
 double filter_freqhi;
 double filter_freqlo;
 
 void updateFilter() {
-  int ncoeff = filterList[current_filter_mode].coeff;
-  float32_t centref = (filterList[current_filter_mode].freqLow + filterList[current_filter_mode].freqHigh) / 2.0;
-  const float32_t maxgain = 2.0;
-  float32_t gain, multiplier;
-  
-  audioFilter(fir_active1,
-    ncoeff,
-    filterList[current_filter_mode].filterType,
-    filterList[current_filter_mode].window,
-    filterList[current_filter_mode].freqLow,
-    filterList[current_filter_mode].freqHigh);
-
-  //Don't forget - the FIR filters happen before decimation, so are at the full sample rate...
-  gain = getFilterGain(fir_active1, ncoeff, centref, SAMPLE_RATE);
-
-  if (DEBUG) Serial.printf("FIR default gain measured as %f\n", gain);
-
-  // Try limiting the max 'gain' to something 'sensible'. Well, OK, I'd like it so we never
-  // need to apply any gain to the FIR coefficients in the first place, but that is not what we seem
-  // to get from the FIR dynamic calculators.
-  if (1.0/gain > maxgain){
-    if (DEBUG) Serial.println("Clipping FIR gain");
-    multiplier = maxgain;
-  } else {
-    multiplier = 1.0/gain;
-  }
-
-  //Scale the multiplier down to 90%, so we avoid any risk of clipping
-  multiplier *= 0.9;
-
-  if (DEBUG) Serial.printf("FIR multiplier set to %f\n", multiplier);
-  
-  //And scale it so we try not to be at 100% for a pure signal, to try and avoid
-  // any potential clipping (unlikely it is that we will ever end up in that situation).
-  normaliseCoeffs(fir_active1, ncoeff, multiplier);
-
-  firfilter.begin(fir_active1, ncoeff);
+  // Presets, and filters we have used recently, come straight from the cache.
+  // Anything new gets generated outside of the audio processing by
+  // filter_cache_service().
+  filter_cache_request(&filterList[current_filter_mode]);
 
   filter_freqlo = filterList[current_filter_mode].freqLow;
   filter_freqhi = filterList[current_filter_mode].freqHigh;
@@ -178,6 +169,12 @@ CHOOSE(current_filter_mode,filterModeMenu,"Flt Md",updateFilter,enterEvent,noSty
   ,VALUE("CW",2,updateFilter,enterEvent)
   ,VALUE("AM",3,updateFilter,enterEvent)
   ,VALUE("FM",4,updateFilter,enterEvent)
+  ,VALUE("CW IIR",5,updateFilter,enterEvent)
+);
+
+CHOOSE(fir_path,firPathMenu,"Flt Pth",updateFilter,enterEvent,noStyle
+  ,VALUE("Float",FIR_PATH_FLOAT,updateFilter,enterEvent)
+  ,VALUE("Int16",FIR_PATH_Q15,updateFilter,enterEvent)
 );
 
 MENU(filterTweaksMenu, "Filter Tweaks", Menu::doNothing, Menu::noEvent, Menu::wrapStyle
@@ -189,6 +186,7 @@ MENU(filterTweaksMenu, "Filter Tweaks", Menu::doNothing, Menu::noEvent, Menu::wr
 MENU(FilterMenu, "Filter menu", Menu::doNothing, Menu::noEvent, Menu::wrapStyle
   ,SUBMENU(filterModeMenu)
   ,SUBMENU(filterTweaksMenu)
+  ,SUBMENU(firPathMenu)
   ,EXIT("<Back")
 );
 
@@ -218,6 +216,8 @@ void updateAGC() {
       agc_sg5k_decay );
     audio_unmute();
   } else {
+    //Start the software AGC from a clean slate when we switch to it
+    if (agc_mode == AGC_MODE_SW) agc_reset();
     audio_mute();
     sgtl5000_1.autoVolumeDisable();    
     //FIXME - this should be a more global decision if we start to use the
@@ -232,6 +232,7 @@ CHOOSE(agc_mode,AGCChoose,"AGC Typ",doNothing,noEvent,noStyle
   ,VALUE("Off",AGC_MODE_OFF,updateAGC,enterEvent | exitEvent | updateEvent)
   ,VALUE("Track",AGC_MODE_TRACK,updateAGC,enterEvent | exitEvent | updateEvent)
   ,VALUE("SG5K",AGC_MODE_SG5K,updateAGC,enterEvent | exitEvent | updateEvent)
+  ,VALUE("Soft",AGC_MODE_SW,updateAGC,enterEvent | exitEvent | updateEvent)
 );
 
 MENU(AGCMenu, "AGC Menu", Menu::doNothing, Menu::noEvent, Menu::wrapStyle
@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Decoder benchmark - see morseBench.h
+
+#include <Arduino.h>
+#include <arm_math.h>
+#include <ctype.h>
+
+#include "global.h"
+#include "morseBench.h"
+#include "morseSynth.h"
+#include "morseDecode.h"
+#include "morseHmm.h"
+#include "envelope.h"
+#include "k4icy.h"
+#include "tf3lj_dec.h"
+
+#define FRAME 256
+
+static const char corpus[] =
+  "CQ CQ DE GI4ABC GI4ABC K "
+  "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG "
+  "RST 599 5NN NAME JIM QTH BELFAST 73 ES GL "
+  "1234567890 / ? . , ";
+
+struct decoder {
+  int mode;
+  const char *name;
+};
+
+static const struct decoder decoders[] = {
+  { DECODER_MORSE, "WB7FHC" },
+  { DECODER_MORSE_K4ICY, "K4ICY" },
+  { DECODER_MORSE_TF3LJ, "TF3LJ" },
+  { DECODER_MORSE_HMM, "HMM" },
+};
+
+#define DECODERS (sizeof(decoders) / sizeof(decoders[0]))
+
+// Grid of speeds and SNRs, all with a bit of hand keying
+static const float32_t wpms[] = { 15, 25, 40 };
+static const float32_t snrs[] = { 3, 6, 10, 20 };
+#define JITTER 0.1
+
+static struct envelope env;
+static struct morse_synth synth;
+static float32_t buf[FRAME];
+
+static char text[DECODERS][MORSE_BENCH_TEXT_MAX + 1];
+static int text_len[DECODERS];
+static uint32_t cycles[DECODERS];
+static int capturing = -1;
+
+static int rows[2][MORSE_BENCH_TEXT_MAX + 1];
+
+bool morse_bench_capture(char c) {
+  if (capturing < 0) return false;
+
+  // Word spaces do not count, so do not bother keeping them
+  if ((c != ' ') && (text_len[capturing] < MORSE_BENCH_TEXT_MAX)) {
+    text[capturing][text_len[capturing]++] = c;
+  }
+  return true;
+}
+
+static void reset_decoders(void) {
+  morseReset();
+  k4icy_setup();
+  tf3lj_dec_init();
+  hmm_init();
+}
+
+// Edit distance between what we sent (less the spaces) and what we got
+static int distance(const char *sent, const char *got, int got_len) {
+  int *prev = rows[0], *cur = rows[1];
+  int sent_len = 0;
+
+  for (int j = 0; j <= got_len; j++) prev[j] = j;
+
+  for (const char *p = sent; *p; p++) {
+    if (*p == ' ') continue;
+    sent_len++;
+
+    cur[0] = sent_len;
+    for (int j = 1; j <= got_len; j++) {
+      int d = prev[j - 1] + ((toupper(got[j - 1]) == *p) ? 0 : 1);
+
+      if (prev[j] + 1 < d) d = prev[j] + 1;
+      if (cur[j - 1] + 1 < d) d = cur[j - 1] + 1;
+      cur[j] = d;
+    }
+
+    int *t = prev;
+    prev = cur;
+    cur = t;
+  }
+  return prev[got_len];
+}
+
+static int sent_length(void) {
+  int n = 0;
+
+  for (const char *p = corpus; *p; p++) {
+    if (*p != ' ') n++;
+  }
+  return n;
+}
+
+// Send the corpus, and hand every key state to all the decoders at once.
+// clock is where the decoders' time carries on from.
+static void run(void (*key)(int mode, bool down, unsigned long now), float32_t samplerate,
+  const struct morse_synth_params *p, unsigned long *clock) {
+  struct key_edge e;
+  unsigned long start;
+  uint32_t got;
+
+  reset_decoders();
+  for (unsigned d = 0; d < DECODERS; d++) {
+    text_len[d] = 0;
+    cycles[d] = 0;
+  }
+
+  morse_synth_init(&synth, samplerate, corpus, p);
+  envelope_init(&env, samplerate);
+  start = envelope_ms(&env, envelope_now(&env));
+
+  do {
+    got = morse_synth_render(&synth, buf, FRAME);
+    envelope_process(&env, buf, got, p->pitch);
+
+    // Every edge, and then the state now - as the main loop does
+    bool more = true;
+    while (more) {
+      bool down;
+      unsigned long now;
+
+      if (envelope_pop(&env, &e)) {
+        down = e.key;
+        now = *clock + envelope_ms(&env, e.timestamp) - start;
+      } else {
+        down = envelope_key(&env);
+        now = *clock + envelope_ms(&env, envelope_now(&env)) - start;
+        more = false;
+      }
+
+      for (unsigned d = 0; d < DECODERS; d++) {
+        uint32_t c = ARM_DWT_CYCCNT;
+
+        capturing = d;
+        key(decoders[d].mode, down, now);
+        capturing = -1;
+        cycles[d] += ARM_DWT_CYCCNT - c;
+      }
+    }
+  } while (got == FRAME);
+
+  *clock += envelope_ms(&env, envelope_now(&env)) - start + MORSE_BENCH_GAP_MS;
+}
+
+static void report(const struct morse_synth_params *p, int sent_len) {
+  // Cycles the audio we decoded would have given us
+  float32_t audio_cycles = (float32_t)F_CPU_ACTUAL * synth.samples / synth.rate;
+
+  Serial.printf(" %2.0fwpm", p->wpm);
+  if (p->farnsworth_wpm > 0.0) Serial.printf("/%2.0f", p->farnsworth_wpm);
+  Serial.printf(" %2.0fdB", p->snr_db);
+  if (p->qsb_depth > 0.0) Serial.print(" QSB");
+  if (p->qrn_per_sec > 0.0) Serial.print(" QRN");
+  Serial.print(":");
+
+  for (unsigned d = 0; d < DECODERS; d++) {
+    Serial.printf(" %s %.1f%% %.3f%% %lu/ch", decoders[d].name,
+      distance(corpus, text[d], text_len[d]) * 100.0 / sent_len, cycles[d] * 100.0 / audio_cycles,
+      (unsigned long)(cycles[d] / (text_len[d] ? text_len[d] : 1)));
+  }
+  Serial.println();
+}
+
+void morse_benchmark(void (*key)(int mode, bool down, unsigned long now), float32_t samplerate) {
+  struct morse_synth_params p = {};
+  unsigned long clock = millis();
+  int sent_len = sent_length();
+
+  Serial.println("Decoder benchmark - character error rate, CPU per second decoded, and cycles per character:");
+
+  p.pitch = morse_frequency;
+  p.jitter = JITTER;
+  p.seed = 1;
+
+  for (unsigned w = 0; w < sizeof(wpms) / sizeof(wpms[0]); w++) {
+    for (unsigned s = 0; s < sizeof(snrs) / sizeof(snrs[0]); s++) {
+      p.wpm = wpms[w];
+      p.snr_db = snrs[s];
+      run(key, samplerate, &p, &clock);
+      report(&p, sent_len);
+    }
+  }
+
+  // ... and one rough one - Farnsworth, more jitter, deep QSB and some QRN
+  p.wpm = 25.0;
+  p.farnsworth_wpm = 15.0;
+  p.snr_db = 10.0;
+  p.jitter = 0.2;
+  p.qsb_depth = 0.8;
+  p.qsb_hz = 0.3;
+  p.qrn_per_sec = 2.0;
+  p.qrn_level = 5.0;
+  run(key, samplerate, &p, &clock);
+  report(&p, sent_len);
+
+  // Leave them as we found them
+  reset_decoders();
+}
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Decoder benchmark - so a change to a decoder is judged on numbers, not on
+// ear.
+//
+// A corpus of text is rendered by the CW generator (morseSynth.h) at a
+// grid of speeds and SNRs, run through the envelope detector, and handed to
+// each decoder in turn. We catch what it prints, and report over USB serial:
+//  - the character error rate - the edit distance from what was sent, over
+//    its length, ignoring the word spaces, and
+//  - the CPU the decoder took, as a percentage of the audio time it decoded,
+//    and in cycles for each character it printed.
+//
+// It runs on the Teensy itself, at start up in DEBUG builds, like the filter
+// benchmarks, and on a PC with "make -C host bench" (see host/main.cpp). It
+// feeds the decimated stream direct, so the input filters and NR are not
+// part of it.
+
+#ifndef MORSEBENCH_H
+#define MORSEBENCH_H
+
+#include <arm_math.h>
+
+// Longest decoded text we keep from a run
+#define MORSE_BENCH_TEXT_MAX   400
+
+// Gap in the time the decoders see between one run and the next, so every
+// one of them has long finished the last
+#define MORSE_BENCH_GAP_MS     10000
+
+// key hands a key state, timed in ms, to decoder mode - the same way the
+// main loop does. samplerate is that of the decimated stream.
+extern void morse_benchmark(void (*key)(int mode, bool down, unsigned long now), float32_t samplerate);
+
+// morsePrint() hands us every character. Returns true if we took it.
+extern bool morse_bench_capture(char c);
+
+#endif
@@ -2,7 +2,9 @@
 #define MORSE_H
 
 // Function prototypes
-void morseKeyUp();
-void morseKeyDown();
+// now is the time of the key state, in ms
+void morseKeyUp(unsigned long now);
+void morseKeyDown(unsigned long now);
 extern int morseWPM();
+extern void morseReset();
 #endif
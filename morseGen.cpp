@@ -4,10 +4,12 @@
 
 #include "global.h"
 
-#include "rgb_lcd.h"
 #include "morseGen.h"
-
-extern rgb_lcd lcd;
+#include "pitchTrack.h"
+#include "ensemble.h"
+#include "morseBench.h"
+#include "textSink.h"
+#include "tf3lj.h"
 
 // WARNING - the teensy 4.0 onboard led on pin13 is also shared with the SDcard on the
 // audio daughterboard - so, if we ever go to use that SD slot, we'll need to find another
@@ -17,15 +19,13 @@ extern rgb_lcd lcd;
 
 void morsePrint(char c)
 {
-  static char buf[17] = "                ";
-
-  memcpy(buf, buf+1, 15);
-  buf[15] = c;
+  //In ensemble mode the decoders do not get to print - they get voted on
+  if (ensemble_capture(c)) return;
+  //... and nor while they are being benchmarked
+  if (morse_bench_capture(c)) return;
 
-  if (display ) {
-    lcd.setCursor(0, 0);
-    lcd.print(buf);
-  }
+  //The LCD and USB get it later, when the loop has time
+  text_sink_push(c, millis());
 }
 
 void morseLed(bool on)
@@ -41,5 +41,7 @@ void morseLed(bool on)
 void morseInit() {                                  // Speak callsign on boot   
   toneDetect.frequency(morse_frequency, morse_cycles);
   toneDetect.threshold(morse_threshold);
+  peakFrq = morse_frequency;  //And TF3LJ's bins
+  pitch_track_invalidate();   //Tracker needs to tune it again, if it is on
   pinMode(ledPin, OUTPUT);
 }
@@ -0,0 +1,349 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Probabilistic morse decoder - see morseHmm.h
+
+#include <Arduino.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "morseHmm.h"
+#include "morseGen.h"
+#include "morseTable.h"
+
+#define ROOT MORSE_START
+#define NODES MORSE_NUMBERS
+
+// The element in progress has been going on for ever - a guess starting
+// out, or one just after a word gap we have printed
+#define LONG_AGO 1e6
+
+struct hyp {
+  float32_t score;
+  float32_t acc;        // ms of the element in progress, glitches and all
+  uint16_t node;        // Element number of the elements before it
+  bool mark;            // Is the element in progress a mark?
+  uint8_t len;
+  uint16_t text[HMM_TEXT]; // Decoded, but not printed yet - element numbers, 0 for a word gap
+};
+
+// A few guesses at each speed - [speed][guess]
+struct beam {
+  struct hyp hyp[HMM_SPEEDS][HMM_PER_SPEED];
+  int count[HMM_SPEEDS];
+};
+
+static struct beam beams[2];
+static struct beam *beam = &beams[0], *next = &beams[1];
+
+static float32_t log_dit[HMM_SPEEDS];
+static float32_t dit_ms[HMM_SPEEDS];
+static bool alive[NODES];     // Is, or leads on to, a real character
+static float32_t log3, log7;   // Of a dah or character gap, and a word gap, in dits
+
+static bool key = false;
+static bool started = false;  // Seen a mark since the last flush
+static unsigned long seg_start;   // When the key last changed
+static unsigned long budget_start;
+static int budget_used;
+static bool last_space = true;
+
+static bool is_char(int node) {
+  return (node > ROOT) && (morse_text(node) != NULL);
+}
+
+// Start again at every speed, as if after a long gap
+static void reset_beam(void) {
+  for (int s = 0; s < HMM_SPEEDS; s++) {
+    beam->hyp[s][0].score = 0.0;
+    beam->hyp[s][0].acc = LONG_AGO;
+    beam->hyp[s][0].node = ROOT;
+    beam->hyp[s][0].mark = false;
+    beam->hyp[s][0].len = 0;
+    beam->count[s] = 1;
+  }
+}
+
+void hmm_init(void) {
+  for (int i = 0; i < HMM_SPEEDS; i++) {
+    log_dit[i] = logf(HMM_DIT_MIN_MS) + i * (logf(HMM_DIT_MAX_MS) - logf(HMM_DIT_MIN_MS)) / (HMM_SPEEDS - 1);
+    dit_ms[i] = expf(log_dit[i]);
+  }
+
+  log3 = logf(3.0);
+  log7 = logf(HMM_WORD_DITS);
+
+  for (int n = 0; n < NODES; n++) alive[n] = false;
+  for (int n = ROOT + 1; n < NODES; n++) {
+    if (!is_char(n)) continue;
+    for (int m = n; m >= ROOT; m >>= 1) alive[m] = true;
+  }
+
+  reset_beam();
+  key = started = false;
+  seg_start = budget_start = 0;
+  budget_used = 0;
+  last_space = true;
+}
+
+// Best guess of all, and its speed
+static struct hyp *best_hyp(int *speed) {
+  struct hyp *best = NULL;
+
+  for (int s = 0; s < HMM_SPEEDS; s++) {
+    for (int i = 0; i < beam->count[s]; i++) {
+      if (!best || (beam->hyp[s][i].score > best->score)) {
+        best = &beam->hyp[s][i];
+        if (speed) *speed = s;
+      }
+    }
+  }
+  return best;
+}
+
+// How well a duration (as a log) fits units dits at this speed
+static float32_t fit(float32_t logd, int speed, float32_t log_units, float32_t sigma) {
+  float32_t z = (logd - log_dit[speed] - log_units) / sigma;
+  float32_t f = -0.5 * z * z;
+
+  return (f < HMM_OUTLIER) ? HMM_OUTLIER : f;
+}
+
+// How likely it is that a key change lasting ms at this speed was not the
+// sender at all - noise making a mark (a spike), or a dropout in one
+static float32_t glitch(float32_t ms, int speed, bool spike) {
+  if (spike) return HMM_SPIKE - ms / (HMM_SPIKE_DITS * dit_ms[speed]);
+  return HMM_DROPOUT - ms / (HMM_DROPOUT_DITS * dit_ms[speed]);
+}
+
+// A candidate for the next beam - h moved to node, with an element of
+// acc ms in progress, at speed, having decoded the character sym (0 for
+// none), and then maybe a word gap.
+static void offer(const struct hyp *h, int node, bool mark, float32_t acc, int speed, float32_t score,
+  int sym, bool space) {
+  struct hyp *bucket = next->hyp[speed];
+  int *count = &next->count[speed];
+  int slot = -1;
+
+  // No room to say any more - it has run well away from the best anyway
+  if (h->len + (sym ? 1 : 0) + (space ? 1 : 0) > HMM_TEXT) return;
+
+  // Same state as one we have? Viterbi - keep the better of the two.
+  for (int i = 0; i < *count; i++) {
+    if ((bucket[i].node == node) && (bucket[i].mark == mark)) {
+      if (score <= bucket[i].score) return;
+      slot = i;
+      break;
+    }
+  }
+
+  if (slot < 0) {
+    if (*count < HMM_PER_SPEED) {
+      slot = (*count)++;
+    } else {
+      // Full - push out the worst, if we are better
+      slot = 0;
+      for (int i = 1; i < *count; i++) {
+        if (bucket[i].score < bucket[slot].score) slot = i;
+      }
+      if (score <= bucket[slot].score) return;
+    }
+  }
+
+  struct hyp *n = &bucket[slot];
+  *n = *h;
+  n->score = score;
+  n->node = node;
+  n->mark = mark;
+  n->acc = acc;
+  if (sym) n->text[n->len++] = sym;
+  if (space) {
+    // Only the one space, however long the gap
+    bool prev = n->len ? (n->text[n->len - 1] == 0) : last_space;
+    if (!prev) n->text[n->len++] = 0;
+  }
+}
+
+// The gap h has in progress is over, and was between characters or words.
+// What we have must be a real character.
+static void end_char(const struct hyp *h, int speed, float32_t base, float32_t logd, bool mark, float32_t acc) {
+  if ((h->node != ROOT) && !is_char(h->node)) return;
+
+  int sym = (h->node == ROOT) ? 0 : h->node;
+  float32_t word = (logd > log_dit[speed] + log7) ? 0.0 : fit(logd, speed, log7, HMM_SPACE_SIGMA);
+
+  if (sym) base += HMM_CHAR_COST;
+
+  offer(h, ROOT, mark, acc, speed, base + fit(logd, speed, log3, HMM_SPACE_SIGMA), sym, false);
+  offer(h, ROOT, mark, acc, speed, base + word, sym, true);
+}
+
+// The element h has in progress is over, at this speed, and a new one of
+// ms has started
+static void end_element(const struct hyp *h, int speed, float32_t base, float32_t ms) {
+  float32_t logd = logf(h->acc < 1.0 ? 1.0 : h->acc);
+
+  if (h->mark) {
+    int dit = morse_append(h->node, false), dah = morse_append(h->node, true);
+
+    if ((dit < NODES) && alive[dit]) offer(h, dit, false, ms, speed, base + fit(logd, speed, 0.0, HMM_MARK_SIGMA), 0, false);
+    if ((dah < NODES) && alive[dah]) offer(h, dah, false, ms, speed, base + fit(logd, speed, log3, HMM_MARK_SIGMA), 0, false);
+    return;
+  }
+
+  // A gap inside a character
+  if (h->node != ROOT) offer(h, h->node, true, ms, speed, base + fit(logd, speed, 0.0, HMM_SPACE_SIGMA), 0, false);
+
+  end_char(h, speed, base, logd, true, ms);
+}
+
+static void print_char(int sym) {
+  const char *text = sym ? morse_text(sym) : " ";
+
+  while (*text) morsePrint(*text++);
+  last_space = (sym == 0);
+}
+
+// Every guess drops its oldest character
+static void shift_all(void) {
+  for (int s = 0; s < HMM_SPEEDS; s++) {
+    for (int i = 0; i < beam->count[s]; i++) {
+      struct hyp *h = &beam->hyp[s][i];
+
+      if (h->len == 0) continue;
+      h->len--;
+      memmove(h->text, h->text + 1, h->len * sizeof(h->text[0]));
+    }
+  }
+}
+
+// Print the oldest of the best guess, once it has held it long enough
+static void commit(void) {
+  struct hyp *b;
+
+  while ((b = best_hyp(NULL))->len >= HMM_LAG) {
+    print_char(b->text[0]);
+    shift_all();
+  }
+}
+
+// Gone quiet - print all of the best guess, and keep going from there
+static void flush(void) {
+  struct hyp *b = best_hyp(NULL);
+  int len = b->len;
+
+  for (int i = 0; i < len; i++) print_char(b->text[i]);
+  for (int i = 0; i < len; i++) shift_all();
+}
+
+// next is the new beam - swap over, and keep the scores near zero
+static void swap(void) {
+  bool any = false;
+
+  for (int s = 0; s < HMM_SPEEDS; s++) {
+    if (next->count[s]) any = true;
+  }
+
+  if (!any) {
+    // Nothing we know fits - more than seven elements, say. Say so and
+    // start afresh.
+    flush();
+    morsePrint('#');
+    last_space = false;
+    reset_beam();
+    return;
+  }
+
+  struct beam *t = beam;
+  beam = next;
+  next = t;
+
+  float32_t top = best_hyp(NULL)->score;
+  for (int s = 0; s < HMM_SPEEDS; s++) {
+    for (int i = 0; i < beam->count[s]; i++) beam->hyp[s][i].score -= top;
+  }
+}
+
+// The key was mark (or not) for ms. For each guess that is either more of
+// the element it has in progress - because the last change was a glitch, or
+// this one is - or the end of that element and the start of the next.
+static void observe(bool mark, float32_t ms) {
+  for (int s = 0; s < HMM_SPEEDS; s++) next->count[s] = 0;
+
+  for (int from = 0; from < HMM_SPEEDS; from++) {
+    for (int i = 0; i < beam->count[from]; i++) {
+      const struct hyp *h = &beam->hyp[from][i];
+
+      if (h->mark == mark) {
+        offer(h, h->node, mark, h->acc + ms, from, h->score, 0, false);
+        continue;
+      }
+
+      offer(h, h->node, h->mark, h->acc + ms, from, h->score + glitch(ms, from, mark), 0, false);
+
+      for (int s = from - 1; s <= from + 1; s++) {
+        if ((s < 0) || (s >= HMM_SPEEDS)) continue;
+        end_element(h, s, h->score + ((s != from) ? HMM_SPEED_STEP : HMM_SPEED_STAY), ms);
+      }
+    }
+  }
+
+  swap();
+  commit();
+}
+
+// Quiet for ms since the last change, and that is the end of the word.
+// Whatever each guess had in progress is over, the gap as well.
+static void end_word(float32_t ms) {
+  observe(false, ms);
+
+  for (int s = 0; s < HMM_SPEEDS; s++) next->count[s] = 0;
+
+  for (int s = 0; s < HMM_SPEEDS; s++) {
+    for (int i = 0; i < beam->count[s]; i++) {
+      const struct hyp *h = &beam->hyp[s][i];
+
+      if (h->mark) continue;
+      end_char(h, s, h->score, logf(h->acc < 1.0 ? 1.0 : h->acc), false, LONG_AGO);
+    }
+  }
+
+  swap();
+  flush();
+}
+
+static float32_t best_dit_ms(void) {
+  int speed = 0;
+
+  best_hyp(&speed);
+  return dit_ms[speed];
+}
+
+void hmm_key(bool down, unsigned long now) {
+  if (down != key) {
+    // Past our budget - leave this change for later. A short one is
+    // gone before we get to it, just as if it were a glitch.
+    if (now - budget_start >= HMM_BUDGET_MS) {
+      budget_start = now;
+      budget_used = 0;
+    }
+    if (budget_used >= HMM_BUDGET_CHANGES) return;
+    budget_used++;
+
+    observe(key, now - seg_start);
+    if (down) started = true;
+    key = down;
+    seg_start = now;
+    return;
+  }
+
+  // Long enough up to be sure the word is over?
+  if (!down && started && (now - seg_start > HMM_FLUSH_DITS * best_dit_ms())) {
+    end_word(now - seg_start);
+    seg_start = now;
+    started = false;
+  }
+}
+
+int hmm_wpm(void) {
+  return (int)(1200.0 / best_dit_ms() + 0.5);
+}
@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Probabilistic morse decoder - a hidden Markov model over the mark and
+// space durations, decoded with a bounded beam Viterbi search.
+//
+// The other decoders decide dit or dah, and which sort of gap, one element
+// at a time against a threshold, and live with the mistakes. Here we keep
+// several guesses going at once. A guess (hypothesis) is:
+//  - where we are in the character - the element number so far, built the
+//    way morseTable.h keys them (start bit, then 1 for a dit, 0 for a dah), and
+//  - the sender's speed, as one of a ladder of dit lengths.
+// Each mark or space that comes in extends every guess in every way that
+// still makes sense, scored by how well the duration fits (log normal
+// around 1 or 3 dits for a mark, 1, 3 or 7 for a space), and by how likely
+// a change of speed is. Only sequences that are, or lead to, real
+// characters survive, so a dodgy element gets sorted out by what follows.
+// One of the ways is that the key change was a glitch - a noise spike in a
+// gap, or a dropout in a mark - so the element in progress just carries on,
+// at a cost that grows with how long the glitch lasted. There is no
+// threshold to guess at beforehand; what follows decides that too.
+// Guesses that land in the same state are merged, keeping the best
+// (that is the Viterbi part), and only the best HMM_PER_SPEED at each speed
+// are kept. Keeping some at every speed means a burst of noise cannot
+// talk us out of the right speed for good.
+//
+// Each guess carries the last few characters it decoded. Once the best one
+// is holding HMM_LAG characters we print the oldest, and every guess drops
+// its oldest - by then they have nearly always agreed on it.
+//
+// Everything is fixed size. A key change gives each guess at most 10
+// candidates - the glitch, and at each of three speeds a dit or a dah, or
+// an element, character or word gap - so at most HMM_BEAM * 10, each a few
+// multiplies and a scan of a speed's guesses. We take at most
+// HMM_BUDGET_CHANGES changes in any HMM_BUDGET_MS, so twice that in one
+// frame at worst; past that we ignore them, which is what would happen to
+// a glitch anyway. It is counted under CPU_STAGE_DECODE with the rest.
+
+#ifndef MORSEHMM_H
+#define MORSEHMM_H
+
+#include <arm_math.h>
+
+// Speed ladder - dit lengths spaced evenly on a log scale
+#define HMM_SPEEDS        16
+#define HMM_DIT_MIN_MS    20      // 60wpm
+#define HMM_DIT_MAX_MS    240     // 5wpm
+
+// Guesses we keep at each speed, and so in all
+#define HMM_PER_SPEED     4
+#define HMM_BEAM          (HMM_SPEEDS * HMM_PER_SPEED)
+
+// log probabilities of the speed stepping up or down one rung per element
+#define HMM_SPEED_STEP    -2.3    // 0.1
+#define HMM_SPEED_STAY    -0.22   // 0.8
+
+// Spread of the durations, as a standard deviation of the log
+#define HMM_MARK_SIGMA    0.4
+#define HMM_SPACE_SIGMA   0.35
+
+// Worst score one duration can give - so a noise spike or a dropout costs
+// a guess something, but does not finish it off
+#define HMM_OUTLIER       -8.0
+
+// log probability charged for each character. Read at three times the speed,
+// dits look like dahs and element gaps like character gaps, and everything
+// comes out as strings of T - this makes the one long character cheaper
+// than the several short ones.
+#define HMM_CHAR_COST     -1.0
+
+// Word gaps can be as long as they like - past 7 dits they all score the same
+#define HMM_WORD_DITS     7
+
+// log probability of a key change lasting ms being a glitch rather than the
+// sender: HMM_SPIKE less one for every HMM_SPIKE_DITS dits it lasts for
+// noise making a mark in a gap, and the same for a dropout in a mark. At low
+// SNR the envelope gives us more spikes than dropouts, but a spike has to be
+// short to pass for one.
+#define HMM_SPIKE         -4.0
+#define HMM_SPIKE_DITS    0.2
+#define HMM_DROPOUT       -3.0
+#define HMM_DROPOUT_DITS  0.25
+
+// Most key changes we take in HMM_BUDGET_MS
+#define HMM_BUDGET_MS       23
+#define HMM_BUDGET_CHANGES  8
+
+// Characters each guess holds before we commit to the oldest
+#define HMM_LAG           4
+#define HMM_TEXT          (HMM_LAG + 2)
+
+// Key up this many dits (at the best guess's speed) and we call it the
+// end of a word and print everything.
+#define HMM_FLUSH_DITS    10
+
+extern void hmm_init(void);
+
+// Key state at time now, in ms - every edge, and then once a frame
+extern void hmm_key(bool down, unsigned long now);
+
+extern int hmm_wpm(void);
+
+#endif
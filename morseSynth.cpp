@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// CW signal generator - see morseSynth.h
+
+#include <Arduino.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "morseSynth.h"
+#include "morseTable.h"
+
+// xorshift - quick, and the same numbers every time for the same seed
+static float32_t uniform(struct morse_synth *s) {
+  uint32_t x = s->rng;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  s->rng = x;
+  return (x >> 8) * (1.0 / 16777216.0);
+}
+
+// Box-Muller
+static float32_t gauss(struct morse_synth *s) {
+  float32_t u1 = uniform(s) + 1e-7, u2 = uniform(s);
+
+  return sqrtf(-2.0 * logf(u1)) * arm_cos_f32(2.0 * PI * u2);
+}
+
+// A length in samples, give or take the keying jitter
+static float32_t jittered(struct morse_synth *s, float32_t samples) {
+  float32_t v = samples * (1.0 + s->p.jitter * gauss(s));
+
+  return (v < 0.25 * samples) ? 0.25 * samples : v;
+}
+
+// The current element or gap has run out - on to the next
+static void next(struct morse_synth *s) {
+  if (s->key) {
+    s->key = false;
+    if (s->mask) {
+      s->left += jittered(s, s->dit);
+    } else if (s->text[s->pos] == 0) {
+      s->tail = MORSE_SYNTH_TAIL_MS * s->rate / 1000.0;
+    } else {
+      s->left += jittered(s, (s->text[s->pos] == ' ') ? s->word_gap : s->char_gap);
+    }
+    return;
+  }
+
+  // Start of a character - skip the spaces (we did the gap already), and
+  // anything we cannot send
+  while (s->mask == 0) {
+    char c = s->text[s->pos];
+
+    if (c == 0) {
+      s->tail = MORSE_SYNTH_TAIL_MS * s->rate / 1000.0;
+      return;
+    }
+    s->pos++;
+    s->num = morse_number(c);
+    if (s->num <= MORSE_START) continue;
+
+    s->mask = 1;
+    while ((s->mask << 1) <= s->num) s->mask <<= 1;
+    s->mask >>= 1;          // Below the start bit
+  }
+
+  bool dah = !(s->num & s->mask);
+
+  s->mask >>= 1;
+  s->key = true;
+  s->left += jittered(s, dah ? 3.0 * s->dit : s->dit);
+}
+
+void morse_synth_init(struct morse_synth *s, float32_t samplerate, const char *text,
+  const struct morse_synth_params *params) {
+  float32_t fw = params->farnsworth_wpm;
+
+  s->p = *params;
+  s->rate = samplerate;
+  s->text = text;
+  s->pos = 0;
+  s->num = 0;
+  s->mask = 0;
+
+  s->dit = 1.2 / s->p.wpm * samplerate;
+  if ((fw > 0.0) && (fw < s->p.wpm)) {
+    // ARRL Farnsworth timing - the gaps take up the slack
+    float32_t ta = (60.0 * s->p.wpm - 37.2 * fw) / (fw * s->p.wpm);
+
+    s->char_gap = 3.0 * ta / 19.0 * samplerate;
+    s->word_gap = 7.0 * ta / 19.0 * samplerate;
+  } else {
+    s->char_gap = 3.0 * s->dit;
+    s->word_gap = 7.0 * s->dit;
+  }
+
+  s->key = false;
+  s->left = MORSE_SYNTH_LEADIN_MS * samplerate / 1000.0;
+  s->tail = -1.0;
+  s->shape = 0.0;
+  s->ramp = 1000.0 / (MORSE_SYNTH_RAMP_MS * samplerate);
+
+  s->phase = 0.0;
+  s->phase_step = 2.0 * PI * s->p.pitch / samplerate;
+  s->qsb_phase = 0.0;
+  s->qsb_step = 2.0 * PI * s->p.qsb_hz / samplerate;
+
+  // Carrier power against the noise power that falls in the bandwidth
+  s->noise_sd = MORSE_SYNTH_LEVEL * sqrtf(0.5 / powf(10.0, s->p.snr_db / 10.0) *
+    (samplerate / 2.0) / MORSE_SYNTH_SNR_BW_HZ);
+  s->qrn = 0.0;
+  s->qrn_decay = expf(-1000.0 / (MORSE_SYNTH_QRN_MS * samplerate));
+
+  s->rng = s->p.seed ? s->p.seed : 1;
+  s->samples = 0;
+}
+
+uint32_t morse_synth_render(struct morse_synth *s, float32_t *buf, uint32_t n) {
+  const float32_t qrn_chance = s->p.qrn_per_sec / s->rate;
+
+  for (uint32_t i = 0; i < n; i++) {
+    if (s->tail >= 0.0) {
+      if (s->tail < 1.0) return i;
+      s->tail -= 1.0;
+    } else {
+      while ((s->left <= 0.0) && (s->tail < 0.0)) next(s);
+      s->left -= 1.0;
+    }
+
+    if (s->key) {
+      s->shape += s->ramp;
+      if (s->shape > 1.0) s->shape = 1.0;
+    } else {
+      s->shape -= s->ramp;
+      if (s->shape < 0.0) s->shape = 0.0;
+    }
+
+    // Raised cosine ramps, and the fading
+    float32_t gain = 0.5 - 0.5 * arm_cos_f32(PI * s->shape);
+    gain *= 1.0 - s->p.qsb_depth * (0.5 - 0.5 * arm_cos_f32(s->qsb_phase));
+
+    float32_t v = MORSE_SYNTH_LEVEL * gain * arm_sin_f32(s->phase);
+
+    s->phase += s->phase_step;
+    if (s->phase > 2.0 * PI) s->phase -= 2.0 * PI;
+    s->qsb_phase += s->qsb_step;
+    if (s->qsb_phase > 2.0 * PI) s->qsb_phase -= 2.0 * PI;
+
+    if ((qrn_chance > 0.0) && (uniform(s) < qrn_chance)) s->qrn = s->p.qrn_level * MORSE_SYNTH_LEVEL;
+    if (s->qrn > 1e-6) {
+      v += s->qrn * gauss(s);
+      s->qrn *= s->qrn_decay;
+    }
+
+    buf[i] = v + s->noise_sd * gauss(s);
+    s->samples++;
+  }
+  return n;
+}
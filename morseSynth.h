@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// CW signal generator - renders text into audio, with the things that make
+// real signals hard to copy: sloppy hand keying, QSB fading, QRN crashes
+// and band noise. It is what the decoder benchmark (morseBench.h) feeds the
+// decoders with, so a change to a decoder can be judged by the numbers.
+//
+// Timing follows the PARIS convention - a dit is 1200/wpm ms. With
+// Farnsworth spacing the characters go at wpm, but the gaps between
+// characters and words are stretched so the text as a whole comes out at
+// farnsworth_wpm (the ARRL formula).
+//
+// Everything lives in the struct, and the noise comes from our own seeded
+// generator, so the same settings give the same audio every time.
+
+#ifndef MORSESYNTH_H
+#define MORSESYNTH_H
+
+#include <arm_math.h>
+
+// Rise and fall of each element, so they do not click
+#define MORSE_SYNTH_RAMP_MS     4
+
+// The SNR is of the carrier against the noise in this bandwidth
+#define MORSE_SYNTH_SNR_BW_HZ   500
+
+// Carrier peak, leaving room for the noise and the QRN
+#define MORSE_SYNTH_LEVEL       0.1
+
+// Quiet before the text starts and after it ends, so the decoders settle
+// on the noise first, and print their last word at the end.
+#define MORSE_SYNTH_LEADIN_MS   1000
+#define MORSE_SYNTH_TAIL_MS     3000
+
+// Each QRN crash dies away this fast
+#define MORSE_SYNTH_QRN_MS      3
+
+struct morse_synth_params {
+  float32_t wpm;
+  float32_t farnsworth_wpm;   // 0, or the same as wpm, for none
+  float32_t pitch;            // Hz
+  float32_t jitter;           // Spread of each element and gap, as a fraction of it
+  float32_t qsb_depth;        // 0 for none, up to 1 for fading right out
+  float32_t qsb_hz;           // How fast it fades
+  float32_t qrn_per_sec;      // 0 for none
+  float32_t qrn_level;        // Peak of a crash, against the carrier
+  float32_t snr_db;
+  uint32_t seed;
+};
+
+struct morse_synth {
+  struct morse_synth_params p;
+  float32_t rate;
+
+  const char *text;
+  int pos;                    // Next character of text to send
+
+  // Element number of the character being sent, and the bit of it that
+  // is next (0 once it is done) - see morseTable.h
+  int num;
+  int mask;
+
+  bool key;
+  float32_t left;             // Samples left of this element or gap
+  float32_t dit, char_gap, word_gap;  // Samples
+  float32_t tail;             // Samples left after the text - -1 until we get there
+
+  float32_t shape;            // 0 to 1, following key with the ramps
+  float32_t ramp;             // per sample
+
+  float32_t phase, phase_step;
+  float32_t qsb_phase, qsb_step;
+  float32_t noise_sd;
+  float32_t qrn, qrn_decay;
+
+  uint32_t rng;
+  uint32_t samples;           // Rendered so far
+};
+
+extern void morse_synth_init(struct morse_synth *s, float32_t samplerate, const char *text,
+  const struct morse_synth_params *params);
+
+// Render up to n samples. Returns how many - fewer than n once the text,
+// and the quiet after it, are done.
+extern uint32_t morse_synth_render(struct morse_synth *s, float32_t *buf, uint32_t n);
+
+#endif
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// The morse code table - see morseTable.h
+
+#include <Arduino.h>
+
+#include "morseTable.h"
+
+struct symbol {
+  const char *code;
+  const char *text;
+};
+
+// Everything the decoders know. Where two codes give the same character the
+// first one here is the one we send.
+static constexpr struct symbol symbols[] = {
+  { ".-", "A" },       { "-...", "B" },     { "-.-.", "C" },     { "-..", "D" },
+  { ".", "E" },        { "..-.", "F" },     { "--.", "G" },      { "....", "H" },
+  { "..", "I" },       { ".---", "J" },     { "-.-", "K" },      { ".-..", "L" },
+  { "--", "M" },       { "-.", "N" },       { "---", "O" },      { ".--.", "P" },
+  { "--.-", "Q" },     { ".-.", "R" },      { "...", "S" },      { "-", "T" },
+  { "..-", "U" },      { "...-", "V" },     { ".--", "W" },      { "-..-", "X" },
+  { "-.--", "Y" },     { "--..", "Z" },
+
+  { ".----", "1" },    { "..---", "2" },    { "...--", "3" },    { "....-", "4" },
+  { ".....", "5" },    { "-....", "6" },    { "--...", "7" },    { "---..", "8" },
+  { "----.", "9" },    { "-----", "0" },
+
+  { ".-.-.-", "." },   { "--..--", "," },   { "..--..", "?" },   { ".----.", "'" },
+  { "-.-.--", "!" },   { "-..-.", "/" },    { "---...", ":" },   { "-.-.-.", ";" },
+  { "-....-", "-" },   { "..--.-", "_" },   { ".-..-.", "\"" },  { "...-..-", "$" },
+  { ".--.-.", "@" },   { "-.--.-", ")" },
+
+  // Prosigns with a character of their own
+  { ".-.-.", "+" },    // AR - end of message
+  { "-...-", "=" },    // BT - pause
+  { "-.--.", "(" },    // KN - over to you only
+  { ".-...", "&" },    // AS - wait
+
+  // No room for accents on the LCD - the nearest plain letter will do
+  { ".-.-", "A" },     // Ä
+  { ".--.-", "A" },    // Á, Å
+  { "-.-..", "C" },    // Ç
+  { "..-..", "E" },    // É
+  { "---.", "O" },     // Ö
+  { "..--", "U" },     // Ü
+  { "--.--", "N" },    // Ñ
+
+  // Prosigns without
+  { "...-.-", "sk" },  // end of contact
+  { "...-.", "sn" },   // understood
+  { "-...-.-", "bk" }, // break
+  { "-.-..-..", "cl" }, // closing station
+  { "-.-.-", "ka" },   // starting signal
+  { "-.-.--.-", "cq" },
+  { "...---...", "sos" },
+  { "........", "err" },
+};
+
+#define SYMBOLS (sizeof(symbols) / sizeof(symbols[0]))
+
+static constexpr int length_of(const char *s) {
+  int n = 0;
+
+  while (s[n]) n++;
+  return n;
+}
+
+static constexpr int number_of(const char *code) {
+  int num = MORSE_START;
+
+  for (; *code; code++) num = num * 2 + ((*code == '.') ? 1 : 0);
+  return num;
+}
+
+static constexpr bool table_fits(void) {
+  for (unsigned i = 0; i < SYMBOLS; i++) {
+    if (length_of(symbols[i].code) > MORSE_ELEMENTS_MAX) return false;
+  }
+  return true;
+}
+
+static constexpr bool codes_unique(void) {
+  for (unsigned i = 0; i < SYMBOLS; i++) {
+    for (unsigned j = i + 1; j < SYMBOLS; j++) {
+      if (number_of(symbols[i].code) == number_of(symbols[j].code)) return false;
+    }
+  }
+  return true;
+}
+
+static_assert(table_fits(), "morse symbol longer than MORSE_ELEMENTS_MAX");
+static_assert(codes_unique(), "morse code listed twice");
+
+struct tables {
+  uint8_t symbol[MORSE_NUMBERS];   // Element number to symbols[] + 1, 0 for none
+  uint16_t number[128];            // Character to element number, 0 for none
+};
+
+static constexpr struct tables build_tables(void) {
+  struct tables t = {};
+
+  for (unsigned i = 0; i < SYMBOLS; i++) {
+    const char *text = symbols[i].text;
+    unsigned char c = text[0];
+    int num = number_of(symbols[i].code);
+
+    t.symbol[num] = i + 1;
+    if ((text[1] == 0) && (c < 128) && (t.number[c] == 0)) t.number[c] = num;
+  }
+  return t;
+}
+
+static constexpr struct tables table = build_tables();
+
+int morse_append(int num, bool dah) {
+  if (num >= MORSE_NUMBERS / 2) return MORSE_NUMBERS;
+  return num * 2 + (dah ? 0 : 1);
+}
+
+const char *morse_text(int num) {
+  if ((num < MORSE_START) || (num >= MORSE_NUMBERS)) return NULL;
+
+  int i = table.symbol[num];
+  return i ? symbols[i - 1].text : NULL;
+}
+
+int morse_number(char c) {
+  unsigned char u = c;
+
+  if ((u >= 'a') && (u <= 'z')) u -= 'a' - 'A';
+  if ((u == 0) || (u >= 128)) return 0;
+  return table.number[u];
+}
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// The morse code table, shared by all the decoders (and anything that
+// wants to send).
+//
+// A character is keyed by its element number, built the WB7FHC way: a start
+// bit, then shift left and add 1 for a dit, or 0 for a dah. So E (.) is 3,
+// T (-) is 2, and A (.-) is 6. Every sequence up to MORSE_ELEMENTS_MAX long
+// has its own number, so finding the character is a single table look up -
+// no building strings of dots and dashes and comparing them one by one.
+//
+// The table is built at compile time from one list of codes, and the
+// reverse map (character to element number, for sending) from the same
+// list, so the two cannot disagree.
+//
+// Most symbols are one character. Prosigns that have a character of their
+// own use it (AR is '+', BT '=', KN '(', AS '&'); the rest come out as
+// lower case letters, so they stand out from the text - "sk", "sos".
+
+#ifndef MORSETABLE_H
+#define MORSETABLE_H
+
+// Element number with no elements yet - just the start bit
+#define MORSE_START         1
+
+// Longest sequence we know - SOS, sent as one
+#define MORSE_ELEMENTS_MAX  9
+
+// Element numbers run from MORSE_START up to, but not including, this
+#define MORSE_NUMBERS       (2 << MORSE_ELEMENTS_MAX)
+
+// Add a dit or a dah to an element number. Once it is longer than
+// anything we know it stays at MORSE_NUMBERS, which is never a character.
+extern int morse_append(int num, bool dah);
+
+// The text for an element number, or NULL if it is not a symbol we know
+extern const char *morse_text(int num);
+
+// The element number for a character, for sending. 0 if there is none.
+extern int morse_number(char c);
+
+#endif
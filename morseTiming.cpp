@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Morse timing statistics - see morseTiming.h
+
+#include <Arduino.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "morseTiming.h"
+
+static void stat_set(struct morse_timing_stat *s, float32_t v) {
+  for (int i = 0; i < MORSE_TIMING_WINDOW; i++) s->win[i] = v;
+  s->sum = v * MORSE_TIMING_WINDOW;
+  s->ewma = v;
+  s->pos = 0;
+}
+
+static float32_t stat_mean(const struct morse_timing_stat *s) {
+  return s->sum * (1.0 / MORSE_TIMING_WINDOW);
+}
+
+static void stat_add(struct morse_timing_stat *s, float32_t v) {
+  s->sum += v - s->win[s->pos];
+  s->win[s->pos] = v;
+  s->pos = (s->pos + 1) & (MORSE_TIMING_WINDOW - 1);
+
+  s->ewma += MORSE_TIMING_FOLLOW * (v - s->ewma);
+
+  // The speed has moved on - do not wait for the window to catch up
+  float32_t mean = stat_mean(s);
+  if (fabsf(s->ewma - mean) > MORSE_TIMING_JUMP * mean) stat_set(s, s->ewma);
+}
+
+void morse_timing_init(struct morse_timing *t, float32_t dit_ms) {
+  stat_set(&t->dit, dit_ms);
+  stat_set(&t->dah, 3.0 * dit_ms);
+  stat_set(&t->gap, dit_ms);
+  t->last_mark = 0.0;
+  t->last_gap = 0.0;
+}
+
+float32_t morse_timing_dit(const struct morse_timing *t) {
+  float32_t dit = stat_mean(&t->dit);
+
+  if (dit < MORSE_TIMING_DIT_MIN_MS) return MORSE_TIMING_DIT_MIN_MS;
+  if (dit > MORSE_TIMING_DIT_MAX_MS) return MORSE_TIMING_DIT_MAX_MS;
+  return dit;
+}
+
+// Keep them a sensible distance apart, so one cannot swallow the other
+float32_t morse_timing_dah(const struct morse_timing *t) {
+  float32_t dit = morse_timing_dit(t);
+  float32_t dah = stat_mean(&t->dah);
+
+  if (dah < 2.0 * dit) return 2.0 * dit;
+  if (dah > 4.0 * dit) return 4.0 * dit;
+  return dah;
+}
+
+float32_t morse_timing_gap(const struct morse_timing *t) {
+  float32_t dit = morse_timing_dit(t);
+  float32_t gap = stat_mean(&t->gap);
+
+  if (gap < 0.5 * dit) return 0.5 * dit;
+  if (gap > 2.0 * dit) return 2.0 * dit;
+  return gap;
+}
+
+float32_t morse_timing_threshold(const struct morse_timing *t) {
+  return sqrtf(morse_timing_dit(t) * morse_timing_dah(t));
+}
+
+int morse_timing_wpm(const struct morse_timing *t) {
+  return (int)(6000.0 / (morse_timing_dit(t) + morse_timing_dah(t) + morse_timing_gap(t)) + 0.5);
+}
+
+bool morse_timing_mark(struct morse_timing *t, float32_t ms) {
+  float32_t threshold = morse_timing_threshold(t);
+  bool dah = ms > threshold;
+
+  // A dit and dah pair in one character (no more than a dit apart, give or
+  // take) that the threshold does not split - we are way out, so start again
+  // from them
+  if (t->last_mark > 0.0) {
+    float32_t lo = (ms < t->last_mark) ? ms : t->last_mark;
+    float32_t hi = (ms < t->last_mark) ? t->last_mark : ms;
+
+    if ((hi >= MORSE_TIMING_PAIR_MIN * lo) && (hi <= MORSE_TIMING_PAIR_MAX * lo) &&
+        (t->last_gap <= MORSE_TIMING_PAIR_MIN * lo) && (lo >= MORSE_TIMING_DIT_MIN_MS) &&
+        ((threshold <= lo) || (threshold >= hi))) {
+      stat_set(&t->dit, lo);
+      stat_set(&t->dah, hi);
+      stat_set(&t->gap, (t->last_gap > 0.0) ? t->last_gap : lo);
+      t->last_mark = ms;
+      return ms == hi;
+    }
+  }
+
+  // Noise spikes and stuck keys are not a change of speed - keep them out
+  if ((ms >= MORSE_TIMING_OUTLIER * morse_timing_dit(t)) && (ms * MORSE_TIMING_OUTLIER <= morse_timing_dah(t))) {
+    stat_add(dah ? &t->dah : &t->dit, ms);
+  }
+  t->last_mark = ms;
+  return dah;
+}
+
+void morse_timing_space(struct morse_timing *t, float32_t ms) {
+  if (ms <= morse_timing_threshold(t)) stat_add(&t->gap, ms);
+
+  // Kept whatever it is - we judge whether the marks either side are in one
+  // character by it, not by a threshold that may be way out
+  t->last_gap = ms;
+}
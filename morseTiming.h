@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Morse timing statistics - the dit, dah and element gap lengths of the
+// signal we are copying, and so its speed.
+//
+// Each length is kept two ways, both O(1) an update:
+//  - a windowed mean of the last MORSE_TIMING_WINDOW of them, held as a
+//    running sum - steady against a sloppy fist, and what we hand out, and
+//  - an exponentially weighted average, which follows faster. If it ends up
+//    more than MORSE_TIMING_JUMP away from the window, the speed has changed
+//    and we fill the window from it, rather than wait for it to roll over.
+//
+// Marks are told apart by the geometric mean of the dit and the dah. That
+// alone gets stuck after a big change of speed - every mark lands on one side
+// and the other length never moves. So, as K4ICY does, a short and a long
+// mark together in a character, two to five times apart, with the threshold
+// not between them, re-seeds the lot from the pair.
+//
+// Times are in ms, but nothing here minds what the unit is as long as it is
+// the same throughout - except the limits on the dit, and the WPM.
+
+#ifndef MORSETIMING_H
+#define MORSETIMING_H
+
+#include <arm_math.h>
+
+// Lengths the windowed means are over - a power of two
+#define MORSE_TIMING_WINDOW     8
+
+// How fast the exponential averages follow
+#define MORSE_TIMING_FOLLOW     0.25
+
+// How far, as a fraction, the exponential average may get from the window
+// before we call it a change of speed
+#define MORSE_TIMING_JUMP       0.5
+
+// A mark shorter than this many dits, or longer than this many dahs the
+// other way round, is a noise spike or a stuck key - we classify it, but it
+// does not go into the averages
+#define MORSE_TIMING_OUTLIER    0.5
+
+// Ratio range a dit and dah pair must be in to re-seed from
+#define MORSE_TIMING_PAIR_MIN   2.0
+#define MORSE_TIMING_PAIR_MAX   5.0
+
+// Speed range we will follow, as a dit in ms
+#define MORSE_TIMING_DIT_MIN_MS 12      // 100wpm
+#define MORSE_TIMING_DIT_MAX_MS 240     // 5wpm
+
+// A dit where there is nothing better to start from - 15wpm
+#define MORSE_TIMING_DIT_START_MS 80
+
+struct morse_timing_stat {
+  float32_t ewma;
+  float32_t win[MORSE_TIMING_WINDOW];
+  float32_t sum;
+  int pos;
+};
+
+struct morse_timing {
+  struct morse_timing_stat dit, dah, gap;
+  float32_t last_mark;          // 0 until we have seen one
+  float32_t last_gap;           // since last_mark
+};
+
+// Start again at a dit of dit_ms, dah three times that
+extern void morse_timing_init(struct morse_timing *t, float32_t dit_ms);
+
+// A mark ms long - returns true if it is a dah
+extern bool morse_timing_mark(struct morse_timing *t, float32_t ms);
+
+// The key was up ms before the next mark. Only element gaps count towards
+// the gap length.
+extern void morse_timing_space(struct morse_timing *t, float32_t ms);
+
+extern float32_t morse_timing_dit(const struct morse_timing *t);
+extern float32_t morse_timing_dah(const struct morse_timing *t);
+extern float32_t morse_timing_gap(const struct morse_timing *t);
+
+// Between a dit and a dah - the geometric mean of the two
+extern float32_t morse_timing_threshold(const struct morse_timing *t);
+
+// PARIS speed - a dit, a dah and an element gap are five units
+extern int morse_timing_wpm(const struct morse_timing *t);
+
+#endif
@@ -183,3 +183,26 @@ void alt_noise_blanking(float* insamp, int Nsam, float* E )
   }
   //end of test timing zone
 }
+
+// The cheap version - no prediction, we just blank the impulse and a few
+// samples either side of it. Used when we are short of CPU.
+void nb_gate(float* insamp, int Nsam)
+{
+  const int half = (NB_impulse_samples - 1) / 2;
+  float32_t rms, threshold;
+
+  arm_rms_f32(insamp, Nsam, &rms);
+  threshold = NB_thresh * NB_GATE_RATIO * rms;
+
+  for (int i = 0; i < Nsam; i++)
+  {
+    if ((insamp[i] > threshold) || (insamp[i] < -threshold))
+    {
+      int first = (i > half) ? i - half : 0;
+      int last = (i + half < Nsam) ? i + half : Nsam - 1;
+
+      for (int j = first; j <= last; j++) insamp[j] = 0.0;
+      i = last;
+    }
+  }
+}
@@ -1,2 +1,6 @@
-
 extern void alt_noise_blanking(float* insamp, int Nsam, float* E );
+
+// Cheap impulse gate - blanks anything more than NB_GATE_RATIO * NB_thresh
+// times the frame RMS, without the LPC prediction and repair.
+#define NB_GATE_RATIO 2.0
+extern void nb_gate(float* insamp, int Nsam);
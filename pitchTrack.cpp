@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// CW pitch acquisition and tracking - see pitchTrack.h
+
+#include <Audio.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "pitchTrack.h"
+#include "spectrum.h"
+#include "tuning.h"
+#include "tf3lj.h"
+
+static int state = PITCH_OFF;
+static float32_t pitch;
+static float32_t applied = -1.0;
+
+static float32_t candidate;
+static int hits = 0;
+
+static uint32_t last_estimate = 0;
+static unsigned long last_good_ms;
+
+// Point the detectors at f. The tuning aid's averaged spectrum was around
+// the old centre, so it starts again.
+static void retune(float32_t f) {
+  if (fabsf(f - applied) < PITCH_RETUNE_HZ) return;
+
+  applied = f;
+  toneDetect.frequency(f, morse_cycles);
+  peakFrq = (int16_t)f;
+  tuning_set_centre(f);
+  tuning_reset();
+}
+
+static void enter(int new_state) {
+  if (DEBUG && (new_state != state)) {
+    if (new_state == PITCH_LOCKED) Serial.printf("Pitch locked at %.0fHz\n", pitch);
+    if ((new_state == PITCH_SEARCH) && (state == PITCH_LOCKED)) Serial.println("Pitch lost");
+  }
+
+  state = new_state;
+  hits = 0;
+  spectrum_subscribe(SPECTRUM_SUB_PITCH, state == PITCH_SEARCH);
+}
+
+void pitch_track_frame(bool enabled) {
+  unsigned long ms = millis();
+
+  if (!enabled) {
+    if (state != PITCH_OFF) enter(PITCH_OFF);
+    pitch = morse_frequency;
+    retune(pitch);
+    return;
+  }
+
+  switch (state) {
+    case PITCH_OFF:
+      enter(PITCH_SEARCH);
+      //Fall through
+
+    case PITCH_SEARCH: {
+      float32_t f, mag;
+
+      // Sit on the user's pitch until we find something
+      pitch = morse_frequency;
+      retune(pitch);
+
+      // Gaps between the elements do not count against a candidate, only
+      // a carrier somewhere else does.
+      if (!spectrum_peak(PITCH_MIN_HZ, PITCH_MAX_HZ, &f, &mag)) break;
+
+      if ((hits > 0) && (fabsf(f - candidate) < PITCH_ACQUIRE_TOL_HZ)) {
+        candidate = (candidate + f) / 2.0;
+        hits++;
+      } else {
+        candidate = f;
+        hits = 1;
+      }
+
+      if (hits >= PITCH_ACQUIRE_HITS) {
+        pitch = candidate;
+        retune(pitch);
+        last_good_ms = ms;
+        enter(PITCH_LOCKED);
+      }
+      break;
+    }
+
+    case PITCH_LOCKED: {
+      struct tuning_estimate te;
+
+      if (tuning_read(&te) && (te.version != last_estimate)) {
+        last_estimate = te.version;
+
+        if (te.confidence >= PITCH_MIN_CONFIDENCE) {
+          // The offset is from where the tuning aid is centred (applied),
+          // which only moves in PITCH_RETUNE_HZ steps - so close the loop on
+          // where the signal is, not on the offset.
+          pitch += PITCH_FLL_GAIN * (te.freq - pitch);
+          if (pitch < PITCH_MIN_HZ) pitch = PITCH_MIN_HZ;
+          if (pitch > PITCH_MAX_HZ) pitch = PITCH_MAX_HZ;
+          retune(pitch);
+          last_good_ms = ms;
+        }
+      }
+
+      if (ms - last_good_ms > PITCH_LOST_MS) enter(PITCH_SEARCH);
+      break;
+    }
+  }
+}
+
+void pitch_track_invalidate(void) {
+  applied = -1.0;
+}
+
+int pitch_track_state(void) {
+  return state;
+}
+
+float32_t pitch_track_freq(void) {
+  return applied;
+}
+
+char pitch_track_marker(void) {
+  switch (state) {
+    case PITCH_SEARCH:
+      return '?';
+    case PITCH_LOCKED:
+      return 'L';
+  }
+  return 0x07;    //The special morse tuning char
+}
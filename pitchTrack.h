@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// CW pitch acquisition and tracking.
+//
+// With tracking on, we look for the strongest carrier in the passband of
+// the shared spectrum, and once it has been there for a few looks in a row
+// we lock on to it. From then on the zoom FFT tuning aid is centred on our
+// pitch, and its estimate drives a frequency locked loop to follow any drift.
+// The tone detector and TF3LJ are retuned to follow. If the signal goes away
+// for long enough we drop the lock and go back to searching.
+
+#ifndef PITCHTRACK_H
+#define PITCHTRACK_H
+
+#include <arm_math.h>
+
+enum pitch_state {
+  PITCH_OFF,        // Not tracking - decoders sit on morse_frequency
+  PITCH_SEARCH,
+  PITCH_LOCKED
+};
+
+// Where we look for a carrier
+#define PITCH_MIN_HZ          300
+#define PITCH_MAX_HZ          1200
+
+// Looks at the spectrum that must agree, and how closely, before we lock
+#define PITCH_ACQUIRE_HITS    4
+#define PITCH_ACQUIRE_TOL_HZ  50
+
+// Fraction of the gap between our pitch and the tuning aid's estimate we
+// correct by each look, and the confidence we need from it to use it
+#define PITCH_FLL_GAIN        0.3
+#define PITCH_MIN_CONFIDENCE  0.3
+
+// No confident estimate for this long and we let go - long enough to ride
+// over the gaps between overs.
+#define PITCH_LOST_MS         5000
+
+// Only retune the decoders when we move by this much
+#define PITCH_RETUNE_HZ       2
+
+// Call once a frame while decoding, after the tuning aid has had the audio.
+// enabled is the user setting - tracking is also dropped when not decoding.
+extern void pitch_track_frame(bool enabled);
+
+extern int pitch_track_state(void);
+
+// Where the decoders are tuned right now
+extern float32_t pitch_track_freq(void);
+
+// Status line character - the tuning arrows when not tracking
+extern char pitch_track_marker(void);
+
+// Somebody else has retuned the tone detector - tune it again next frame.
+extern void pitch_track_invalidate(void);
+
+#endif
@@ -13,6 +13,9 @@
 #include "xanr.h"
 #include "LMS_NR.h"
 #include "global.h"
+#include "ik8yfw.h"
+#include "governor.h"
+#include "textSink.h"
 
 #include "settings.h"
 
@@ -238,6 +241,9 @@ struct eedata factory_default_settings =
 static int current_setting = 4; //SSB. FIXME - load from eedata at init time
 
 static void set_setting(struct settings *s) {
+  //New settings, new load - start with everything on again
+  governor_reset();
+
   //Filter
   current_filter_mode = s->filter.preset;
   if (s->filter.lowfreq != 0 )    //FIXME - what if we *do* want to set the freq to 0hz ?
@@ -296,6 +302,7 @@ static void load_setting(int slot) {
     buf[7] = 'y';  
     lcd.setCursor(0, 0);
     lcd.print(buf);
+    text_sink_invalidate();
     return;   //Nothing to load
   } else {
     for( int i=0; i<sizeof(s->name); i++)
@@ -304,6 +311,7 @@ static void load_setting(int slot) {
   
   lcd.setCursor(0, 0);
   lcd.print(buf);
+  text_sink_invalidate();
 
   sgtl5000_1.muteHeadphone();
   sgtl5000_1.muteLineout();
@@ -540,6 +548,14 @@ void set_nr_mode(uint8_t mode) {
       xanr_init();
       break;
 
+    case NR_MODE_FNR:
+      fnrFilter_init(&fnr_state);
+      break;
+
+    case NR_MODE_FNRA:
+      fnrFilter_n_Average_init(&fnra_state);
+      break;
+
     //All other modes don't need any extra (re-)initialisation
     default:
       break;
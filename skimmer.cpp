@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// CW skimmer - see skimmer.h
+
+#include <Arduino.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "skimmer.h"
+#include "spectrum.h"
+#include "morseTable.h"
+
+static struct skimmer_channel channels[SKIMMER_CHANNELS];
+static float32_t score[SPECTRUM_BINS];
+static float32_t rate;
+static uint32_t seen = 0;
+static bool running = false;
+
+void skimmer_init(float32_t samplerate) {
+  rate = samplerate;
+  for (int i = 0; i < SKIMMER_CHANNELS; i++) channels[i].active = false;
+}
+
+// Send what we have of the word
+static void flush_word(int n) {
+  struct skimmer_channel *c = &channels[n];
+
+  if (c->word_len == 0) return;
+  c->word[c->word_len] = '\0';
+  Serial.printf("%2d %4dHz %2dwpm %s\n", n, (int)c->freq, morse_timing_wpm(&c->timing), c->word);
+  c->word_len = 0;
+}
+
+static void add_char(int n, char ch) {
+  struct skimmer_channel *c = &channels[n];
+
+  c->word[c->word_len++] = ch;
+  if (c->word_len == SKIMMER_WORD_MAX) flush_word(n);
+}
+
+// A key state for channel n at time now (ms) - every edge, and then the
+// current state once a frame so we can time out characters and words.
+static void channel_key(int n, bool key, unsigned long now) {
+  struct skimmer_channel *c = &channels[n];
+
+  if (key) {
+    c->last_key = now;
+    if (!c->key) {
+      c->key = true;
+      c->mark_start = now;
+      morse_timing_space(&c->timing, now - c->space_start);
+      if (c->num == 0) c->num = MORSE_START;
+    }
+    return;
+  }
+
+  if (c->key) {
+    float32_t mark = now - c->mark_start;
+
+    c->key = false;
+    c->space_start = now;
+
+    // Too short to be anything - a glitch
+    if (mark < morse_timing_dit(&c->timing) * 0.3) return;
+
+    c->num = morse_append(c->num, morse_timing_mark(&c->timing, mark));
+    return;
+  }
+
+  // Key still up - is the character, or the word, done?
+  unsigned long gap = now - c->space_start;
+  float32_t dit = morse_timing_dit(&c->timing);
+
+  if ((c->num > MORSE_START) && (gap > 2.0 * dit)) {
+    const char *text = morse_text(c->num);
+
+    if (!text) text = "#";
+    while (*text) add_char(n, *text++);
+    c->num = 0;
+  }
+  if ((c->word_len > 0) && (gap > 5.0 * dit)) flush_word(n);
+}
+
+static void channel_start(int n, float32_t freq, float32_t noise) {
+  struct skimmer_channel *c = &channels[n];
+
+  c->active = true;
+  c->freq = freq;
+  envelope_init(&c->env, rate);
+  envelope_seed(&c->env, noise);
+  morse_timing_init(&c->timing, SKIMMER_DIT_START_MS);
+  c->key = false;
+  c->num = 0;
+  c->word_len = 0;
+  c->space_start = c->last_key = millis();
+
+  if (DEBUG) Serial.printf("Skimmer channel %d on %dHz\n", n, (int)freq);
+}
+
+static void channel_stop(int n) {
+  flush_word(n);
+  channels[n].active = false;
+}
+
+// Look for new carriers in any spectra since last time
+static void find_carriers(void) {
+  const struct spectrum *s;
+
+  while ((s = spectrum_next(&seen)) != NULL) {
+    int first = (int)(SKIMMER_MIN_HZ / s->bin_hz);
+    int last = (int)(SKIMMER_MAX_HZ / s->bin_hz);
+    float32_t mean = 0.0, noise = 0.0;
+    int below = 0;
+
+    if (first < 2) first = 2;
+    if (last > SPECTRUM_BINS - 3) last = SPECTRUM_BINS - 3;
+
+    // The noise floor is the average of the bins below the average, so a
+    // few big signals do not hide the small ones.
+    for (int i = first; i <= last; i++) mean += s->mag[i];
+    mean /= (last - first + 1);
+    for (int i = first; i <= last; i++) {
+      if (s->mag[i] < mean) {
+        noise += s->mag[i];
+        below++;
+      }
+    }
+    if (below) noise /= below;
+
+    for (int i = first; i <= last; i++) {
+      bool peak = (s->mag[i] > SKIMMER_PEAK_RATIO * noise) &&
+        (s->mag[i] >= s->mag[i - 1]) && (s->mag[i] > s->mag[i + 1]) &&
+        (s->mag[i] > SKIMMER_NARROW * s->mag[i - 2]) && (s->mag[i] > SKIMMER_NARROW * s->mag[i + 2]);
+
+      score[i] = score[i] * SKIMMER_SCORE_LEAK + (peak ? 1.0 : 0.0);
+      if (!peak || (score[i] < SKIMMER_ACQUIRE)) continue;
+
+      float32_t f = spectrum_bin_freq(s, i);
+      int spare = -1;
+      bool taken = false;
+
+      for (int n = 0; n < SKIMMER_CHANNELS; n++) {
+        if (!channels[n].active) {
+          if (spare < 0) spare = n;
+        } else if (fabsf(channels[n].freq - f) < SKIMMER_SPACING_HZ) {
+          taken = true;
+        }
+      }
+      if (!taken && (spare >= 0)) channel_start(spare, f, noise);
+    }
+  }
+}
+
+void skimmer_process(const float32_t *buf, uint32_t n, bool enabled) {
+  if (!enabled) {
+    if (running) {
+      for (int i = 0; i < SKIMMER_CHANNELS; i++) {
+        if (channels[i].active) channel_stop(i);
+      }
+      spectrum_subscribe(SPECTRUM_SUB_SKIMMER, false);
+      running = false;
+    }
+    return;
+  }
+
+  if (!running) {
+    for (int i = 0; i < SPECTRUM_BINS; i++) score[i] = 0.0;
+    seen = spectrum_latest() ? spectrum_latest()->version : 0;
+    spectrum_subscribe(SPECTRUM_SUB_SKIMMER, true);
+    running = true;
+  }
+
+  find_carriers();
+
+  for (int i = 0; i < SKIMMER_CHANNELS; i++) {
+    struct skimmer_channel *c = &channels[i];
+    struct key_edge e;
+
+    if (!c->active) continue;
+
+    envelope_process(&c->env, buf, n, c->freq);
+    while (envelope_pop(&c->env, &e)) channel_key(i, e.key, envelope_ms(&c->env, e.timestamp));
+
+    unsigned long now = envelope_ms(&c->env, envelope_now(&c->env));
+    channel_key(i, envelope_key(&c->env), now);
+
+    if (now - c->last_key > SKIMMER_IDLE_MS) {
+      if (DEBUG) Serial.printf("Skimmer channel %d free\n", i);
+      channel_stop(i);
+    }
+  }
+}
+
+int skimmer_active(void) {
+  int count = 0;
+
+  for (int i = 0; i < SKIMMER_CHANNELS; i++) {
+    if (channels[i].active) count++;
+  }
+  return count;
+}
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// CW skimmer - decode every carrier in the passband at once.
+//
+// We watch the shared spectrum for carriers that keep coming back in the
+// same bin, and give each one a channel of its own: an envelope detector
+// sat on its pitch, and a small adaptive decoder. Everything a channel
+// needs lives in its own struct, so they do not trip over each other (or
+// over the single signal decoders and their file statics).
+//
+// Decoded text goes out over USB serial a word at a time, tagged with the
+// channel, its pitch and its speed:
+//    3  712Hz 24wpm CQ
+// A channel that has been quiet for a while is freed for the next carrier.
+
+#ifndef SKIMMER_H
+#define SKIMMER_H
+
+#include <arm_math.h>
+
+#include "envelope.h"
+#include "morseTiming.h"
+
+// Each channel costs an envelope detector run over every decimated sample.
+// That is counted in CPU_STAGE_DECODE, which DEBUG builds print once a
+// second - 8 has only been tried with two carriers, so check it there
+// before asking for more.
+#define SKIMMER_CHANNELS      8
+
+// Where we look for carriers
+#define SKIMMER_MIN_HZ        250
+#define SKIMMER_MAX_HZ        3000
+
+// A carrier is a local peak this many times the noise floor, that comes
+// back often enough to build up a score of SKIMMER_ACQUIRE. The score
+// leaks by SKIMMER_SCORE_LEAK each spectrum.
+#define SKIMMER_PEAK_RATIO    4.0
+#define SKIMMER_SCORE_LEAK    0.95
+#define SKIMMER_ACQUIRE       3.0
+
+// A carrier is narrow - it must stand this far above the bins two either
+// side, or it is more likely the skirts of a big signal next door.
+#define SKIMMER_NARROW        2.0
+
+// No two channels closer than this
+#define SKIMMER_SPACING_HZ    80
+
+// A channel with no key down for this long is freed
+#define SKIMMER_IDLE_MS       15000
+
+// Longest word we hold before we send it anyway
+#define SKIMMER_WORD_MAX      24
+
+// Where each channel's speed starts - 30wpm-ish. It follows from there, as
+// morseTiming.h does.
+#define SKIMMER_DIT_START_MS  40
+
+struct skimmer_channel {
+  bool active;
+  float32_t freq;
+  struct envelope env;
+
+  // Decoder timing
+  struct morse_timing timing;
+  unsigned long mark_start;
+  unsigned long space_start;
+  unsigned long last_key;
+  bool key;
+
+  // Element number, 0 between characters - see morseTable.h
+  int num;
+
+  char word[SKIMMER_WORD_MAX + 1];
+  int word_len;
+};
+
+extern void skimmer_init(float32_t samplerate);
+
+// Once a frame, with n decimated samples of what we play out. enabled is
+// whether skimmer mode is on - if not, we flush and free every channel.
+extern void skimmer_process(const float32_t *buf, uint32_t n, bool enabled);
+
+// Channels in use, for the status line
+extern int skimmer_active(void);
+
+#endif
@@ -4,6 +4,12 @@
 
 #include "global.h"
 #include "spectral.h"
+#include "spectrum.h"
+
+// We hand our power spectrum to the shared spectrum as it stands, bin for bin
+// and hop for hop - so the two had better be the same shape.
+static_assert(SPECTRUM_FFT_SIZE == NR_FFT_L, "shared spectrum must be the NR FFT size");
+static_assert(SPECTRUM_HOP == NR_FFT_L / 2, "shared spectrum must hop as the NR does");
 
 float32_t tinc = 0.00145; // frame time 5.3333ms
 float32_t asnr = 20;  // active SNR in dB
@@ -289,6 +295,8 @@ void spectral_noise_reduction (void)
       // this is squared magnitude for the current frame
       NR_X[bindx][0] = (NR_FFT_buffer[bindx * 2] * NR_FFT_buffer[bindx * 2] + NR_FFT_buffer[bindx * 2 + 1] * NR_FFT_buffer[bindx * 2 + 1]);
     }
+    // Same FFT the spectrum service would do - so hand it over
+    spectrum_publish_power(&NR_X[0][0], 3);
 
     if (NR_first_time_2 == 2)
     { // TODO: properly initialize all the variables
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Shared spectrum service - see spectrum.h
+
+#include <Audio.h>
+#include <arm_math.h>
+
+#include "global.h"
+#include "spectrum.h"
+
+static arm_rfft_fast_instance_f32 rfft;
+static float32_t window[SPECTRUM_FFT_SIZE];
+static float32_t history[SPECTRUM_HOP];
+static float32_t fft_in[SPECTRUM_FFT_SIZE];
+static float32_t fft_out[SPECTRUM_FFT_SIZE];
+
+static struct spectrum ring[SPECTRUM_HISTORY];
+static uint32_t version = 0;
+static uint32_t samples = 0;
+static uint32_t subscribers = 0;
+static float32_t bin_hz;
+static float32_t mag_scale;
+
+void spectrum_init(float32_t samplerate) {
+  float32_t sum = 0.0;
+
+  arm_rfft_fast_init_f32(&rfft, SPECTRUM_FFT_SIZE);
+
+  // sqrt Hann, the same as the spectral NR uses
+  for (int i = 0; i < SPECTRUM_FFT_SIZE; i++) {
+    window[i] = sinf(PI * i / (SPECTRUM_FFT_SIZE - 1));
+    sum += window[i];
+  }
+  mag_scale = 2.0 / sum;
+
+  bin_hz = samplerate / SPECTRUM_FFT_SIZE;
+  memset(history, 0, sizeof(history));
+}
+
+void spectrum_subscribe(uint32_t who, bool on) {
+  if (on) subscribers |= who;
+  else subscribers &= ~who;
+}
+
+bool spectrum_wanted(void) {
+  return subscribers != 0;
+}
+
+static struct spectrum *publish_slot(void) {
+  struct spectrum *s = &ring[(version + 1) % SPECTRUM_HISTORY];
+
+  samples += SPECTRUM_HOP;
+  s->timestamp = samples;
+  s->bin_hz = bin_hz;
+  return s;
+}
+
+void spectrum_publish_power(const float32_t *power, int stride) {
+  struct spectrum *s;
+
+  if (!subscribers) {
+    samples += SPECTRUM_HOP;
+    return;
+  }
+
+  s = publish_slot();
+  for (int i = 0; i < SPECTRUM_BINS; i++) s->mag[i] = sqrtf(power[i * stride]) * mag_scale;
+  s->version = ++version;
+}
+
+void spectrum_process(const float32_t *buf, uint32_t n) {
+  //Keep the clock going, even if nobody is looking
+  if (!subscribers) {
+    samples += n;
+    return;
+  }
+
+  for (uint32_t hop = 0; hop + SPECTRUM_HOP <= n; hop += SPECTRUM_HOP) {
+    const float32_t *in = &buf[hop];
+    struct spectrum *s;
+
+    arm_mult_f32(history, window, fft_in, SPECTRUM_HOP);
+    arm_mult_f32((float32_t *)in, &window[SPECTRUM_HOP], &fft_in[SPECTRUM_HOP], SPECTRUM_HOP);
+    memcpy(history, in, sizeof(history));
+
+    arm_rfft_fast_f32(&rfft, fft_in, fft_out, 0);
+    //DC and Nyquist are packed into the first pair - we do not want the Nyquist.
+    fft_out[1] = 0.0;
+
+    s = publish_slot();
+    arm_cmplx_mag_f32(fft_out, s->mag, SPECTRUM_BINS);
+    arm_scale_f32(s->mag, mag_scale, s->mag, SPECTRUM_BINS);
+    s->version = ++version;
+  }
+}
+
+const struct spectrum *spectrum_next(uint32_t *seen) {
+  uint32_t want;
+
+  if (*seen == version) return NULL;
+
+  want = *seen + 1;
+  if (version - want >= SPECTRUM_HISTORY) want = version - SPECTRUM_HISTORY + 1;
+
+  *seen = want;
+  return &ring[want % SPECTRUM_HISTORY];
+}
+
+const struct spectrum *spectrum_latest(void) {
+  if (version == 0) return NULL;
+  return &ring[version % SPECTRUM_HISTORY];
+}
+
+float32_t spectrum_bin_freq(const struct spectrum *s, int pk) {
+  if ((pk < 1) || (pk > SPECTRUM_BINS - 2)) return pk * s->bin_hz;
+
+  // Parabola through the peak and its neighbours, on a log scale
+  float32_t a = logf(s->mag[pk - 1] + 1e-9);
+  float32_t b = logf(s->mag[pk] + 1e-9);
+  float32_t c = logf(s->mag[pk + 1] + 1e-9);
+  float32_t d = a - 2.0 * b + c;
+  float32_t offset = (d < 0.0) ? 0.5 * (a - c) / d : 0.0;
+
+  return (pk + offset) * s->bin_hz;
+}
+
+bool spectrum_peak(float32_t lo, float32_t hi, float32_t *freq, float32_t *mag) {
+  const struct spectrum *s = spectrum_latest();
+  int first, last, pk;
+  float32_t sum = 0.0, best = 0.0;
+
+  if (!s) return false;
+
+  first = (int)(lo / s->bin_hz);
+  last = (int)(hi / s->bin_hz);
+  if (first < 1) first = 1;
+  if (last > SPECTRUM_BINS - 2) last = SPECTRUM_BINS - 2;
+  if (last <= first) return false;
+
+  pk = first;
+  for (int i = first; i <= last; i++) {
+    sum += s->mag[i];
+    if (s->mag[i] > best) {
+      best = s->mag[i];
+      pk = i;
+    }
+  }
+
+  if (best < SPECTRUM_PEAK_RATIO * sum / (last - first + 1)) return false;
+
+  *freq = spectrum_bin_freq(s, pk);
+  *mag = best;
+  return true;
+}
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Shared spectrum of the decimated audio.
+//
+// Rather than everybody running their own analysis at the full rate, we take
+// one magnitude spectrum per hop of the decimated audio, just before the noise
+// reduction, and publish it here. Each spectrum carries a version, bumped on
+// every publish, and the decimated sample count at the end of its window, so
+// readers can tell what is new and when it was.
+//
+// When the spectral NR is running it has already done the very same FFT
+// (same size, hop and window), so it hands its result over and we skip ours.
+// That means SPECTRUM_FFT_SIZE has to move with NR_FFT_L - spectral.cpp will
+// not build if they differ.
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <arm_math.h>
+
+#define SPECTRUM_FFT_SIZE 256
+#define SPECTRUM_BINS     (SPECTRUM_FFT_SIZE / 2)
+#define SPECTRUM_HOP      (SPECTRUM_FFT_SIZE / 2)
+
+// Spectra we keep, so a reader polling once a frame does not miss any.
+#define SPECTRUM_HISTORY  4
+
+// Subscribers - one bit each. We only do the work if somebody wants it.
+#define SPECTRUM_SUB_TF3LJ   (1 << 0)
+#define SPECTRUM_SUB_PITCH   (1 << 1)
+#define SPECTRUM_SUB_SKIMMER (1 << 2)
+
+struct spectrum {
+  uint32_t version;
+  uint32_t timestamp;             // Decimated samples, at the end of the window
+  float32_t bin_hz;
+  float32_t mag[SPECTRUM_BINS];   // A full scale sine reads 1.0
+};
+
+extern void spectrum_init(float32_t samplerate);
+
+extern void spectrum_subscribe(uint32_t who, bool on);
+extern bool spectrum_wanted(void);
+
+// Run our own FFTs over n decimated samples (a multiple of SPECTRUM_HOP).
+extern void spectrum_process(const float32_t *buf, uint32_t n);
+
+// Publish a power spectrum somebody else has already worked out, for the
+// next hop. power[] is |X|^2 of the sqrt Hann windowed FFT, every stride floats.
+extern void spectrum_publish_power(const float32_t *power, int stride);
+
+// The next spectrum after *version, or NULL if there is nothing new. Moves
+// *version along. If the reader has fallen behind they get the oldest we
+// still have.
+extern const struct spectrum *spectrum_next(uint32_t *version);
+
+// Most recent, or NULL if we have not made one yet.
+extern const struct spectrum *spectrum_latest(void);
+
+// Frequency of a peak at bin pk, refined between the bins
+extern float32_t spectrum_bin_freq(const struct spectrum *s, int pk);
+
+// Strongest bin between lo and hi Hz in the latest spectrum, with the
+// frequency refined between the bins. Returns false if nothing stands out
+// of the average by SPECTRUM_PEAK_RATIO.
+#define SPECTRUM_PEAK_RATIO 4.0
+extern bool spectrum_peak(float32_t lo, float32_t hi, float32_t *freq, float32_t *mag);
+
+#endif
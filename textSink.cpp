@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Decoded text sink - see textSink.h
+
+#include <Arduino.h>
+
+#include "global.h"
+#include "rgb_lcd.h"
+#include "textSink.h"
+
+extern rgb_lcd lcd;
+
+struct text_char {
+  char c;
+  unsigned long ms;
+};
+
+static struct text_char ring[TEXT_SINK_SIZE];
+static volatile uint32_t head, tail;
+static int overruns;
+
+// The line as it should be, and as the LCD has it. valid is false when we
+// do not know what the LCD has, and dirty when the line has changed since.
+static char line[TEXT_SINK_COLS];
+static char shown[TEXT_SINK_COLS];
+static bool valid, dirty;
+static unsigned long next_refresh;
+
+// The word going out over USB, and when it started
+static char word[TEXT_SINK_WORD_MAX + 1];
+static int word_len;
+static unsigned long word_ms;
+
+void text_sink_push(char c, unsigned long now) {
+  uint32_t h = head;
+
+  if (h - tail >= TEXT_SINK_SIZE) {
+    if (DEBUG && (overruns++ == 0)) Serial.println("Text sink overrun");
+    return;
+  }
+
+  ring[h & (TEXT_SINK_SIZE - 1)].c = c;
+  ring[h & (TEXT_SINK_SIZE - 1)].ms = now;
+  __sync_synchronize();   //Entry out before the consumer can see it
+  head = h + 1;
+}
+
+static void word_send(void) {
+  if (word_len == 0) return;
+
+  word[word_len] = '\0';
+  Serial.printf("%lu.%03lu %s\n", word_ms / 1000, word_ms % 1000, word);
+  word_len = 0;
+}
+
+static void tap(char c, unsigned long ms) {
+  if (text_tap != TEXT_TAP_ON) {
+    word_len = 0;
+    return;
+  }
+
+  if (c == ' ') {
+    word_send();
+    return;
+  }
+
+  if (word_len == 0) word_ms = ms;
+  word[word_len++] = c;
+  if (word_len >= TEXT_SINK_WORD_MAX) word_send();
+}
+
+static void refresh(void) {
+  int first = 0, last = TEXT_SINK_COLS - 1;
+
+  if (valid) {
+    while ((first <= last) && (line[first] == shown[first])) first++;
+    while ((last >= first) && (line[last] == shown[last])) last--;
+  }
+
+  if (first <= last) {
+    lcd.setCursor(first, 0);
+    for (int i = first; i <= last; i++) {
+      lcd.write(line[i]);
+      shown[i] = line[i];
+    }
+  }
+  valid = true;
+  dirty = false;
+}
+
+void text_sink_service(unsigned long now, bool show) {
+  static bool init = false;
+
+  if (!init) {
+    memset(line, ' ', sizeof(line));
+    init = true;
+  }
+
+  while (tail != head) {
+    uint32_t t = tail;
+    struct text_char e = ring[t & (TEXT_SINK_SIZE - 1)];
+
+    __sync_synchronize();   //Entry read before the producer can reuse it
+    tail = t + 1;
+
+    memmove(line, line + 1, TEXT_SINK_COLS - 1);
+    line[TEXT_SINK_COLS - 1] = e.c;
+    dirty = true;
+
+    tap(e.c, e.ms);
+  }
+
+  //The menu has the LCD - whatever we put there is gone
+  if (!show) {
+    valid = false;
+    dirty = true;
+    return;
+  }
+
+  if (dirty && (now >= next_refresh)) {
+    refresh();
+    next_refresh = now + TEXT_SINK_LCD_MS;
+  }
+}
+
+void text_sink_invalidate(void) {
+  valid = false;
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Decoded text sink - where morsePrint() puts what the decoders say.
+//
+// Writing the scrolling line straight to the LCD for every character is a
+// string of blocking I2C transfers from the middle of the audio loop. So
+// instead the decoders push each character, with the time, into a single
+// producer, single consumer lock free ring, and that is all. Later, when
+// the loop is waiting on audio, text_sink_service() drains the ring into
+// the line and sends the LCD only the characters that changed - at most
+// once every TEXT_SINK_LCD_MS.
+//
+// The same characters can go out over USB serial too (the "USB txt" menu
+// option), a word to a line, with the time the word started:
+//    12.345 CQ
+//    12.901 DE
+
+#ifndef TEXTSINK_H
+#define TEXTSINK_H
+
+// Characters the ring holds - a power of two. Even 60wpm is only about 5
+// a second, so this is many LCD refreshes' worth.
+#define TEXT_SINK_SIZE      64
+
+// Width of the decoded text line on the LCD
+#define TEXT_SINK_COLS      16
+
+// Refresh the LCD no more often than this
+#define TEXT_SINK_LCD_MS    50
+
+// Longest word we hold for USB before we send it anyway
+#define TEXT_SINK_WORD_MAX  32
+
+// A character from a decoder, at time now in ms
+extern void text_sink_push(char c, unsigned long now);
+
+// Drain the ring, and refresh the LCD if it is time. show is false while
+// the menu has the LCD - the line is kept up to date, and redrawn in full
+// once we get the LCD back.
+extern void text_sink_service(unsigned long now, bool show);
+
+// Someone else wrote over the line on the LCD - redraw all of it when there
+// is next something new to show
+extern void text_sink_invalidate(void);
+
+#endif
@@ -9,63 +9,100 @@
 #include "morseGen.h"
 
 #include "tf3lj.h"
+#include "spectrum.h"
 
 
 int16_t peakFrq;
 float32_t agcvol = 1.0;
 int16_t vol = 1024;      //Default full volume - we rely on the input volume and the AGC. This vol is redundant for us.
-int16_t     fftbuf[60];                    // FFT output buffer. Updated by SignalSampler() Interrupt function.
 int16_t     thresh       = 1;     // Audio threshold level (0 - 40)
 bool        state;                // Current decoded signal state
 sigbuf      sig[SIG_BUFSIZE];     // A circular buffer of decoded input levels and durations, input from
 int32_t     sig_lastrx   = 0;     // Circular buffer in pointer, updated by SignalSampler
 int32_t     sig_incount  = 0;     // Circular buffer in pointer, copy of sig_lastrx, used by CW Decode functions
 int32_t     sig_outcount = 0;     // Circular buffer out pointer, used by CW Decode functions
- // Elapsed time of current signal state, in units of the
- // FFT conversion time. approx 2.9ms for FFT256 with no averaging
- // or 11.6ms for FFT1024 with no averaging.  Updated by SignalSampler.
+ // Elapsed time of current signal state, in units of approx 2.9ms (344 to
+ // the second), whatever the spectrum rate.  Updated by tf3lj_process().
 int32_t     sig_timer    = 0;
-int32_t timer_stepsize=FFTAVERAGE;    // Step size of signal timer depends on FFT conversion time, FFT1024=4
+int32_t timer_stepsize = 4;   // Step size of signal timer per spectrum - set in tf3lj_init()
 uint8_t data_len;
 int32_t               cur_time;                     // copy of sig_timer
 
 void tf3lj_init(void) {
-  morse_fft.windowFunction(AudioWindowBlackmanNuttall1024); // Good overall rejection characteristics
+  // One spectrum per hop of the decimated audio - 11.6ms
+  timer_stepsize = (int32_t)(344.0 * SPECTRUM_HOP / (SAMPLE_RATE / DF) + 0.5);
 
-  //FIXME - this needs to be done every time we change the freq etc.
-  //peakFrq = (44100/1024) * morse_frequency;              // BW_of_bin * number of bin
+  // morseInit() and the pitch tracker keep it up to date from then on
   peakFrq = morse_frequency;
 }
 
+static bool prevstate;                      // Last recorded state of signal input (mark or space)
+static bool toneout;                        // Keep track of state changes for tone out
+
+//------------------------------------------------------------------
+// Record state changes and durations onto circular buffer
+static void record_state(void)
+{
+  if (state != prevstate)
+  {
+    // Enter the type and duration of the state change into the circular buffer
+    sig[sig_lastrx].state  = prevstate;
+    sig[sig_lastrx++].time = sig_timer;
+    // Zero circular buffer when at max
+    if (sig_lastrx == SIG_BUFSIZE) sig_lastrx = 0;
+    sig_timer = 0;                                // Zero the signal timer.
+    prevstate = state;                            // Update state
+  }
+
+  //static bool debug;
+  //digitalWrite(LED_PIN, debug ^= 1);            // Debug - measure rate of FFT
+  digitalWrite(LED_PIN, state);                   // Show current state on LED
+
+  //----------------
+  // Tone to Speaker^H^H LED when mark (key-down)
+  if (toneout != state) 
+  {
+    if (state) morseLed(true);
+    else       morseLed(false);
+    toneout = state;
+  } 
+}
+
 //------------------------------------------------------------------
 //
 // Signal Sampler and Change Detection Function
-// Interrupt driven, polls the FFT function once every 200us
-// to see whether it has new data.  Either 256 or 1024 FFT is
-// used to identify tone,
+// Called with each new spectrum from the shared spectrum service
+// (SPECTRUM_FFT_SIZE on the decimated audio - for 256 points at 11025 Hz
+// that is 43 Hz a bin, the same as FFT1024 at the full rate, every 11.6ms
+// rather than FFT1024's 23ms) to identify the tone.
 //
 // Output is a circular buffer, sig[SIG_BUFSIZE], containing
 // timing information for High & Low states.
 //
 //------------------------------------------------------------------
-void tf3lj_process(void)
+void tf3lj_process(const struct spectrum *s)
 {
   static int16_t  siglevel;                 // FFT signal level
   int16_t         lvl=0;                    // Multiuse variable
-  int16_t         pklvl;                    // Used for AGC calculations
+  float32_t       pklvl;                    // Used for AGC calculations
+  float32_t       gain;                     // agcvol and vol together
   int16_t         pk;                       // FFT bin containing peak level
-  static bool     prevstate;                // Last recorded state of signal input (mark or space)
-  static bool     toneout;                  // Keep track of state changes for tone out
+  int16_t         lo, hi;                   // Range of bins peakFrq may be in
+
+  //----------------
+  // Bins from the real bin width of the spectrum, so they follow the
+  // decimated rate and FFT size, and room for the FILTERBW bins either side
+  lo = (int16_t)(LOWFRQ / s->bin_hz + 0.5f) + FILTERBW_BELOW;
+  hi = (int16_t)(HIGHFRQ / s->bin_hz + 0.5f) - FILTERBW_ABOVE;
+  if (hi > SPECTRUM_BINS - 1 - FILTERBW_ABOVE) hi = SPECTRUM_BINS - 1 - FILTERBW_ABOVE;
 
   //----------------
   // Automatic Gain Control (AGC) - using level at peakFrq as basis 
-#if 1 //fft256
-  pk = 4*peakFrq/172 - 1;                       // FFT256 frequency bin number of peak frequency
-  pklvl = agcvol * vol * morse_fft.read(peakFrq/172); // Get level at peak frequency
-#else //fft1024
-  pk = peakFrq/43 - 5;                          // FFT1024 frequency bin number of peak frequency
-  pklvl = agcvol * vol * morse_fft.read(peakFrq/43); // Get level at peak frequency
-#endif
+  pk = (int16_t)(peakFrq / s->bin_hz + 0.5f);      // FFT bin of peak frequency
+  if (pk < lo) pk = lo;
+  if (pk > hi) pk = hi;
+  pklvl = agcvol * vol * s->mag[pk];              // Get level at peak frequency - kept in float, so a
+                                                  // loud bin cannot overflow the int16_t
 
   if (pklvl > 45) agcvol = agcvol * AGC_ATTACK;   // Decrease volume if above this level.
   if (pklvl < 40) agcvol = agcvol * AGC_DECAY;    // Increase volume if below this level.
@@ -74,42 +111,19 @@ void tf3lj_process(void)
   //We see 'good' morse values around 0.002 in the bucket for low level morse.
   //Our volume is set to 1024, and we want to get to about '42.5' (between 40 and 45) with the AGC.
   //Thus, our max agc is going to be about 42.5/(1024*.01) == ~ 4 ??
-#define AGC_MAX 1.5
+#define AGC_MAX 1.5f
   if (agcvol > AGC_MAX) agcvol = AGC_MAX;
 
-#if 1 //fft256
-  for (uint8_t x=0; x<60; x++)
-  {
-    // Get signal level at each frequency, start at 215 Hz (5 * 43 Hz)
-    if (x%4==0) lvl= agcvol * vol *morse_fft.read((x+5)/4);  // Only read every fourth time
-    if (lvl > 40) lvl=40;                       // Cap max at 40
-    fftbuf[x] = lvl;
-    siglevel = fftbuf[pk];                      // Fetch the signal level at peak frequency
-  }
-
-#else //fft1024
-  // Scan through all relevant FFT bins (215 - 2800 Hz)
-  // collect the relevant ones around peakFrq - and plot all to LCD
-  for (uint8_t x=0; x<60; x++)
+  // Average the signal level in the FILTERBW FFT bins around the Peak
+  // frequency - only those, there is no bargraph to draw the rest on
+  gain = agcvol * vol;
+  for (int16_t x = pk - FILTERBW_BELOW; x <= pk + FILTERBW_ABOVE; x++)
   {
-    // Get signal level at each frequency, start at 215 Hz (5 * 43 Hz)
-    lvl = agcvol * vol * morse_fft.read(x+5);
-    if (lvl > 40) lvl = 40;                     // Cap max at 40
-    fftbuf[x] = lvl;     
-    // Average the signal level in 1, 2 ... 5 FFT bins around the Peak frequency
-    #if   FILTERBW == 5
-    siglevel = (fftbuf[pk-2]+fftbuf[pk-1]+fftbuf[pk]+fftbuf[pk+1]+fftbuf[pk+2])/3;
-    #elif FILTERBW == 4
-    siglevel = (fftbuf[pk-1]+fftbuf[pk]+fftbuf[pk+1]+fftbuf[pk+2])/2;
-    #elif FILTERBW == 3
-    siglevel = (fftbuf[pk-1]+fftbuf[pk]+fftbuf[pk+1])/2;
-    #elif FILTERBW == 2
-    (FILTERBW==2) siglevel = (fftbuf[pk]+fftbuf[pk+1])/2;
-    #else
-    siglevel = fftbuf[pk];
-    #endif               
+    // Cap max at 40 before it goes to an int16_t.
+    float32_t v = gain * s->mag[x];
+    lvl += (v > 40.0f) ? 40 : (int16_t)v;
   }
-#endif
+  siglevel = lvl / FILTERBW_DIV;
 
   //----------------
   // Signal averaging (smoothing)
@@ -151,35 +165,32 @@ if(0){
   else                    state = FALSE;
   #endif
 
-  //----------------
-  // Record state changes and durations onto circular buffer
-  if (state != prevstate)
-  {
-    // Enter the type and duration of the state change into the circular buffer
-    sig[sig_lastrx].state  = prevstate;
-    sig[sig_lastrx++].time = sig_timer;
-    // Zero circular buffer when at max
-    if (sig_lastrx == SIG_BUFSIZE) sig_lastrx = 0;
-    sig_timer = 0;                                // Zero the signal timer.
-    prevstate = state;                            // Update state
-  }
+  record_state();
 
   //----------------
   // Count signal state timer upwards based on which sampling rate is in effect
   sig_timer = sig_timer + timer_stepsize;
   if (sig_timer>=344*TIMEOUT) sig_timer = 344*TIMEOUT; // Impose a MAXTIME second boundary for overflow time 
+if(0) Serial.println("");
+}
 
-  //static bool debug;
-  //digitalWrite(LED_PIN, debug ^= 1);            // Debug - measure rate of FFT
-  digitalWrite(LED_PIN, state);                   // Show current state on LED
+//------------------------------------------------------------------
+//
+// Key state from the envelope front end, rather than our own FFT.
+// now is the time of the state in ms - we get every change as it
+// happened, and a call with the current state about once a frame.
+//
+//------------------------------------------------------------------
+void tf3lj_key(bool key, unsigned long now)
+{
+  static unsigned long changed;             // When we last recorded a change
+  unsigned long elapsed = now - changed;
 
-  //----------------
-  // Tone to Speaker^H^H LED when mark (key-down)
-  if (toneout != state) 
-  {
-    if (state) morseLed(true);
-    else       morseLed(false);
-    toneout = state;
-  } 
-if(0) Serial.println("");
+  // Time since the last change, in our 344 to the second units
+  if (elapsed >= 1000*TIMEOUT) elapsed = 1000*TIMEOUT;
+  sig_timer = (int32_t)(elapsed * 344 / 1000);
+
+  state = key;
+  if (state != prevstate) changed = now;
+  record_state();
 }
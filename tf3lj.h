@@ -40,7 +40,11 @@
 #define  DATE    "2016-03-11"
 
 extern void tf3lj_init(void);
-extern void tf3lj_process(void);
+// Feed one spectrum from the shared spectrum service.
+struct spectrum;
+extern void tf3lj_process(const struct spectrum *s);
+// Or feed it key states from the envelope front end, timed in ms.
+extern void tf3lj_key(bool key, unsigned long now);
 
 //
 //-----------------------------------------------------------------------------
@@ -63,6 +67,7 @@ typedef struct {
                } bflags;
 //-----------------------------------------------------------------------------
 
+extern int16_t peakFrq;
 extern int32_t cur_time;
 extern uint8_t data_len;
 extern int32_t sig_incount;
@@ -74,13 +79,15 @@ extern sigbuf      sig[];
 
 //
 // Note on performance:
-// 1024 point and 256 point FFT are user selectable in real time with FFT_SEL_PIN. While the 
-// 1024 FFT provides a much better frequency filter resolution than the 256 fft, the tradeoff
-// is that it provides a lower sampling rate. Approx 11.6ms per sample(512/44100Hz) for a 
-// 1024 point FFT vs. 2.9ms (128/44100Hz) for 256 point FFT. 
-// When using the 1024 FFT, at 20 WPM, the sampling rate is 5 times the "dot" rate, probably 
-// the highest one can go without starting to notice loss in performance.  So if decoding
-// higher rates, then the 256 FFT should be used.
+// The original chose between a 1024 point and a 256 point FFT at 44.1kHz. The 1024 FFT has
+// the better frequency filter resolution (43 Hz bins, against 172 Hz), but gives a lower
+// sampling rate - 11.6ms per sample (512/44100Hz) against 2.9ms (128/44100Hz).
+// Here we take the shared spectrum of the decimated audio instead (spectrum.h). 256 points
+// at 11025Hz gives the 43 Hz bins of the 1024 FFT for the cost of the 256 one, one every
+// 11.6ms. There is no choosing between the two any more - the shared spectrum is the one
+// the spectral NR takes, so its size and hop are fixed by NR_FFT_L (spectral.cpp checks).
+// Bins and timing are worked out from the real rate, so they follow NR_FFT_L or the
+// decimation if either changes.
 //
 // While the user selectable filtering methods below aim at reducing error rate, they all equate
 // to reducing the sampling rate somewhat, and hence impact the performance at higher rates.
@@ -100,24 +107,33 @@ extern sigbuf      sig[];
 
 #define AUDIOOUT_LEVEL   0.3  // Level of sinewave output for the Audio out CW Decode Monitor.
 
-#define AGC_ATTACK      0.95  // Audio automatic gain control (AGC) attack, audio vol reduce per cycle.
-#define AGC_DECAY      1.005  // Audio AGC decay, audio volume increase per cycle.
+#define AGC_ATTACK      0.95f // Audio automatic gain control (AGC) attack, audio vol reduce per cycle.
+#define AGC_DECAY      1.005f // Audio AGC decay, audio volume increase per cycle.
                               // AGC attempts to cap the max signal level at the Fpeak frequency to 40
                               // (40 is arbitrarily picked, is max in FFT bargraph).
 
-#define FILTERBW           3  // If 1024 FFT, then this determines bandwidth of filter in number of FFT bins.
-                              // Each bin is 43 Hz wide. Valid values are 1 - 5. 3 seems to be a good number.
+#define FILTERBW           3  // Bandwidth of filter in number of FFT bins.
+                              // Each bin is the spectrum's bin_hz wide - about 43 Hz. Any width of 1 or
+                              // more will do, as long as it fits in LOWFRQ to HIGHFRQ. 3 seems to be a good number.
+
+#define LOWFRQ           215  // Range of tone frequencies we look for the peak in, Hz
+#define HIGHFRQ         2800
+
+// The FILTERBW bins around the peak - below it, above it, and what their sum
+// is divided by (not quite the average, as the original had it)
+#define FILTERBW_BELOW     ((FILTERBW - 1) / 2)
+#define FILTERBW_ABOVE     (FILTERBW / 2)
+#if FILTERBW == 2
+#define FILTERBW_DIV       2
+#else
+#define FILTERBW_DIV       ((FILTERBW + 1) / 2)
+#endif
 
 //-----------------------------------------------------------------------------  
 // Selection of all sorts of post-filtering, including noise/spike/dropout cancel                           
-#define SIGAVERAGE         2  // N = 1, 2, 3... Probably a better method than FFTAVERAGE.  Also works
-                              // with FFT1024.  Averages (smoothes) signal from N number of samples,
+#define SIGAVERAGE         2  // N = 1, 2, 3... Averages (smoothes) signal from N number of samples,
                               //  but does not slow down sampling rate.  Fights drops and spikes.
 
-#define FFTAVERAGE         2  // N = 1, 2, 3... Used with FFT256.  Averages consecutive FFT reads.
-                              // 2 doubles the the time per conversion.  Does nothing when FFT1024.
-                              // Timing is very jittery, when 1.
-                              
 #define NOISECANCEL        1  // Noise Cancellation by requiring two consecutive reads to be the same
                               // for a state change.  1 to select, 0 to deselect. Normally 1.
 
@@ -143,15 +159,6 @@ extern sigbuf      sig[];
 
 #define NOISE_LEVEL      1.0  // Level of white noise if LOCAL_NOISE source is enabled. 0.0 - 1.0
 
-//-----------------------------------------------------------------------------
-// Decode of International Morse Code Symbols - a somewhat random collection of country specific symbols
-// If you are not using these, then better not to enable.  The fewer unnecessary symbols - the more "meat"
-// the Error Correction function gets to resolve
-#define ICELAND_SYMBOLS    0  // Þ Ð Æ Ö
-#define NOR_DEN_SYMBOLS    0  // Æ Å Ø   - Norway/Denmark - overlaps with Iceland symbols, only select one    
-#define SWEDEN_SYMBOLS     0  // Ä Å Ö   - Sweden - overlaps with above symbols, only select one
-#define REST_SYMBOLS       0  // Ü Ch É Ñ  - a random colletion of symbols
-
 //-----------------------------------------------------------------------------
 // LCD Type QDTech orST7735 
 #define LCD_QDTECH         0  // 128x160 pixel LCD board using a Samsung S6D02A1 chip.
@@ -39,13 +39,14 @@
 #include "tf3lj.h"
 
 #include "tf3lj_dec.h"
+#include "morseTable.h"
 
 bflags                b;                            // Various Operational state flags
-char                  code[DATA_BUFSIZE];           // Decoded dot/dash info in symbol form, e.g. ".-.."                                         
+int                   code;                         // Decoded dot/dash info as an element number - see morseTable.h
 sigbuf                data[DATA_BUFSIZE];           // Buffer containing decoded dot/dash and time information
-double                pulse_avg;                    // CW timing variables - pulse_avg is a composite value
-double                dot_avg, dash_avg;            // Dot and Dash Space averages             
-double                symspace_avg, cwspace_avg;    // Intra symbol Space and Character-Word Space
+float32_t             pulse_avg;                    // CW timing variables - pulse_avg is a composite value
+float32_t             dot_avg, dash_avg;            // Dot and Dash Space averages             
+float32_t             symspace_avg, cwspace_avg;    // Intra symbol Space and Character-Word Space
 int32_t               w_space;                      // Last word space time
 int32_t               last_outcount= 0;             // sig_outcount for previous character, used for Error Correction func
 int32_t               cur_outcount = 0;             // Basically same as sig_outcount, for Error Correction functionality
@@ -53,8 +54,8 @@ int32_t               cur_outcount = 0;             // Basically same as sig_out
 void InitializationFunc(void);
 bool DataRecognitionFunc(void);
 void CodeGenFunc(void);
-uint8_t CharacterIdFunc(void);
-void PrintCharFunc(uint8_t c);
+const char *CharacterIdFunc(void);
+void PrintCharFunc(const char *text);
 void WordSpaceFunc(uint8_t c);
 bool ErrorCorrectionFunc(void);
 
@@ -75,7 +76,7 @@ void tf3lj_dec_init() {
 //------------------------------------------------------------------
 void CW_Decode(void)
 {
-  uint8_t decoded;                                  // 0xff if char not recognized
+  const char *decoded;                              // NULL if char not recognized
   bool    received;                                 // True on a symbol received
 
   //-----------------------------------
@@ -91,12 +92,12 @@ void CW_Decode(void)
     {
       CodeGenFunc();                                // Generate a dot/dash pattern string
       decoded = CharacterIdFunc();                  // Indentify the Character
-      if (decoded < 0xfe)                           // 0xfe = spike suppression, 0xff = error
+      if (decoded && *decoded)                      // "" = spike suppression, NULL = error
       {
         PrintCharFunc(decoded);                     // Print to LCD and Serial (USB)
-        WordSpaceFunc(decoded);                     // Print Word Space to LCD and Serial when required
+        WordSpaceFunc(decoded[0]);                  // Print Word Space to LCD and Serial when required
       }
-      else if (decoded == 0xff)                     // Attempt Error Correction
+      else if (!decoded)                            // Attempt Error Correction
       {
         // Debug
         //Serial.println();
@@ -124,9 +125,10 @@ void InitializationFunc(void)
   static int16_t startpos, progress;                             // Progress counter, size = SIG_BUFSIZE
   static bool    initializing;                                   // Bool for first time init of progress counter
   int16_t        processed;                                      // Number of states that have been processed
-  double         t;                                              // We do timing calculations in floating point
+  float32_t      t;                                              // We do timing calculations in floating point
                                                                  // to gain a little bit of precision when low
-                                                                 // sampling rate
+                                                                 // sampling rate - single precision, as the FPU
+                                                                 // is quicker at it, and ample for 344 ticks/sec
   // Set up progress counter at beginning of initialize
   if (initializing == FALSE)
   {
@@ -161,25 +163,25 @@ void InitializationFunc(void)
       {
         if (t > pulse_avg)
         {
-          dash_avg = dash_avg + (t - dash_avg)/4.0;              // (e.q. 4.5)
+          dash_avg = dash_avg + (t - dash_avg)/4.0f;             // (e.q. 4.5)
         }
         else
         {
-          dot_avg = dot_avg + (t - dot_avg)/4.0;                 // (e.q. 4.4)
+          dot_avg = dot_avg + (t - dot_avg)/4.0f;                // (e.q. 4.4)
         }
       }
       else                                                       // Less than 32, still quite unstable
       {
         if (t > pulse_avg)
         {
-          dash_avg = (t + dash_avg)/2.0;                         // (e.q. 4.2)
+          dash_avg = (t + dash_avg)/2.0f;                        // (e.q. 4.2)
         }
         else
         {
-          dot_avg = (t + dot_avg)/2.0;                           // (e.q. 4.1)
+          dot_avg = (t + dot_avg)/2.0f;                          // (e.q. 4.1)
         }
       }
-      pulse_avg = (dot_avg/4 + dash_avg)/2.0;                    // Update pulse_avg (e.q. 4.3)
+      pulse_avg = (dot_avg/4 + dash_avg)/2.0f;                   // Update pulse_avg (e.q. 4.3)
     }
     else          // Not a pulse - determine character_word space avg
     {
@@ -187,11 +189,11 @@ void InitializationFunc(void)
       {
         if (t > pulse_avg)                                       // Symbol space?
         {
-          cwspace_avg = cwspace_avg + (t - cwspace_avg)/4.0;     // (e.q. 4.8)
+          cwspace_avg = cwspace_avg + (t - cwspace_avg)/4.0f;    // (e.q. 4.8)
         }
         else
         {
-          symspace_avg = symspace_avg +  (t - symspace_avg)/4.0; // New EQ, to assist calculating Rate
+          symspace_avg = symspace_avg +  (t - symspace_avg)/4.0f; // New EQ, to assist calculating Rate
         }
       }
     }         
@@ -210,7 +212,7 @@ void InitializationFunc(void)
 //
 //------------------------------------------------------------------
 #if SPIKECANCEL || SHORTCANCEL
-double spikeCancel(double t)
+float32_t spikeCancel(float32_t t)
 {
   static bool spike;
 
@@ -253,8 +255,8 @@ double spikeCancel(double t)
 //------------------------------------------------------------------
 bool DataRecognitionFunc(void)
 {
-  double        t;                                 // Temporary time
-  double        x = 0;                             // Temp comparison value
+  float32_t     t;                                 // Temporary time
+  float32_t     x = 0;                             // Temp comparison value
   bool          new_char = FALSE;                  // Return value
   static bool   processed;
   
@@ -270,7 +272,7 @@ bool DataRecognitionFunc(void)
     if (sig[sig_outcount].state)
     {
       #if SPIKECANCEL || SHORTCANCEL                // Squash spikes/transients
-      double temp = spikeCancel(t);
+      float32_t temp = spikeCancel(t);
       if (temp == 0) return FALSE;                  // It was a transient
       else t = temp;                                // If last was a transient, then t = last 3 t added together
       #endif
@@ -287,7 +289,7 @@ bool DataRecognitionFunc(void)
       {
         b.dash = FALSE;                             // Clear Dash flag
         data[data_len].state = 0;                   // Store as Dot
-        dot_avg = dot_avg + (t - dot_avg)/8.0;      // Update dot_avg (e.q. 4.6)
+        dot_avg = dot_avg + (t - dot_avg)/8.0f;     // Update dot_avg (e.q. 4.6)
       }
       //-----------------------------------
       // Is it a Dash?
@@ -297,12 +299,12 @@ bool DataRecognitionFunc(void)
         data[data_len].state = 1;                   // Store as Dash
         if (t <= 5*dash_avg)                        // Store time if not stuck key
         {
-          dash_avg = dash_avg + (t - dash_avg)/8.0; // Update dash_avg (e.q. 4.7)
+          dash_avg = dash_avg + (t - dash_avg)/8.0f; // Update dash_avg (e.q. 4.7)
         }      
       }
       data[data_len].time =  (uint32_t) t;          // Store associated time
       data_len++;                                   // Increment by one dot/dash
-      pulse_avg = (dot_avg/4 + dash_avg)/2.0;       // Update pulse_avg (e.q. 4.3)
+      pulse_avg = (dot_avg/4 + dash_avg)/2.0f;      // Update pulse_avg (e.q. 4.3)
     }
     
     //-----------------------------------
@@ -310,7 +312,7 @@ bool DataRecognitionFunc(void)
     else
     {
       #if SPIKECANCEL || SHORTCANCEL                // Squash spikes/transients
-      double temp = spikeCancel(t);
+      float32_t temp = spikeCancel(t);
       if (temp == 0) return FALSE;                  // It was a transient
       else t = temp;                                // If last was a transient, then t = last 3 t added together
       #endif
@@ -323,15 +325,15 @@ bool DataRecognitionFunc(void)
       else if (b.dash == TRUE)                      // Last character was a dash
       {
         b.dash = false;
-        x = t - (pulse_avg - ((uint32_t) data[data_len-1].time - pulse_avg)/4.0);  // (e.q. 4.12, corrected)  
+        x = t - (pulse_avg - ((uint32_t) data[data_len-1].time - pulse_avg)/4.0f); // (e.q. 4.12, corrected)  
         if (x < 0)                                  // Return on symbol space - not a full char yet
         {
-          symspace_avg = symspace_avg + (t - symspace_avg)/8.0; // New EQ, to assist calculating Rat
+          symspace_avg = symspace_avg + (t - symspace_avg)/8.0f; // New EQ, to assist calculating Rat
           return FALSE;
         }
         else if (t <= 10*dash_avg)                  // Current space is not a timeout 
         {
-          x = t - (cwspace_avg - ((uint32_t) data[data_len-1].time - pulse_avg)/4.0);// (e.q. 4.14)
+          x = t - (cwspace_avg - ((uint32_t) data[data_len-1].time - pulse_avg)/4.0f);// (e.q. 4.14)
           if (x >= 0)                               // It is a Word space
           {
             w_space = t;
@@ -344,12 +346,12 @@ bool DataRecognitionFunc(void)
         x = t - pulse_avg;                          // (e.q. 4.11)
         if (x < 0)                                  // Return on symbol space - not a full char yet
         {
-          symspace_avg = symspace_avg + (t - symspace_avg)/8.0; // New EQ, to assist calculating Rate
+          symspace_avg = symspace_avg + (t - symspace_avg)/8.0f; // New EQ, to assist calculating Rate
           return FALSE;         
         }
         else if (t <= 10*dash_avg)                  // Current space is not a timeout  
         {
-          cwspace_avg = cwspace_avg + (t - cwspace_avg)/8.0; // (e.q. 4.9)
+          cwspace_avg = cwspace_avg + (t - cwspace_avg)/8.0f; // (e.q. 4.9)
           x = t - cwspace_avg;                      // (e.q. 4.13)
           if (x >= 0)                               // It is a Word space
           {
@@ -391,138 +393,37 @@ bool DataRecognitionFunc(void)
 //------------------------------------------------------------------
 //
 // The Code Generation Function converts the received
-// character to a string code[] of dots and dashes
+// character to an element number code of dots and dashes
 //
 //------------------------------------------------------------------
 void CodeGenFunc(void)
 {
   uint8_t a;
+  code = MORSE_START;
   for (a = 0; a < data_len; a++)
   {
-    if (data[a].state) code[a] = '-';
-    else code[a] = '.';
+    code = morse_append(code, data[a].state);
   }
-  code[a] = 0;                                      // Terminate string
   data_len = 0;                                     // And make ready for a new Char
 }
 
 
 //------------------------------------------------------------------
 //
-// The Character Identification Function applies dot/dash pattern
-// recognition to identify the received character.
+// The Character Identification Function looks the dot/dash
+// pattern up in the shared morse table to identify the received
+// character.
 //
-// The function returns the ASCII code for the character received,
-// or 0xff if pattern was not recognized.
+// The function returns the text for the character received,
+// or NULL if pattern was not recognized.
 //
 //------------------------------------------------------------------
-uint8_t CharacterIdFunc(void)
- {
-  uint8_t out;
- 
+const char *CharacterIdFunc(void)
+{
   // Should never happen - Empty, spike suppression or similar
-  if (code[0] == 0) out = 0xfe;
-  
-  // TODO, there are a number of ways to make this faster,
-  // but this doesn't seem to be a bottleneck
-  else if (strcmp(code,".-") == 0)    out ='A';
-  else if (strcmp(code,"-...") == 0)  out ='B';
-  else if (strcmp(code,"-.-.") == 0)  out ='C';
-  else if (strcmp(code,"-..") == 0)   out ='D';
-  else if (strcmp(code,".") == 0)     out ='E';
-  else if (strcmp(code,"..-.") == 0)  out ='F';
-  else if (strcmp(code,"--.") == 0)   out ='G';
-  else if (strcmp(code,"....") == 0)  out ='H';
-  else if (strcmp(code,"..") == 0)    out ='I';
-  else if (strcmp(code,".---") == 0)  out ='J';
-  else if (strcmp(code,"-.-") == 0)   out ='K';
-  else if (strcmp(code,".-..") == 0)  out ='L';
-  else if (strcmp(code,"--") == 0)    out ='M';
-  else if (strcmp(code,"-.") == 0)    out ='N';
-  else if (strcmp(code,"---") == 0)   out ='O';
-  else if (strcmp(code,".--.") == 0)  out ='P';
-  else if (strcmp(code,"--.-") == 0)  out ='Q';
-  else if (strcmp(code,".-.") == 0)   out ='R';
-  else if (strcmp(code,"...") == 0)   out ='S';
-  else if (strcmp(code,"-") == 0)     out ='T';
-  else if (strcmp(code,"..-") == 0)   out ='U';
-  else if (strcmp(code,"...-") == 0)  out ='V';
-  else if (strcmp(code,".--") == 0)   out ='W';
-  else if (strcmp(code,"-..-") == 0)  out ='X';
-  else if (strcmp(code,"-.--") == 0)  out ='Y';
-  else if (strcmp(code,"--..") == 0)  out ='Z';
-
-  else if (strcmp(code,".----") == 0) out ='1';
-  else if (strcmp(code,"..---") == 0) out ='2';
-  else if (strcmp(code,"...--") == 0) out ='3';
-  else if (strcmp(code,"....-") == 0) out ='4';
-  else if (strcmp(code,".....") == 0) out ='5';
-  else if (strcmp(code,"-....") == 0) out ='6';
-  else if (strcmp(code,"--...") == 0) out ='7';
-  else if (strcmp(code,"---..") == 0) out ='8';
-  else if (strcmp(code,"----.") == 0) out ='9';
-  else if (strcmp(code,"-----") == 0) out ='0';
-
-  else if (strcmp(code,".-.-.-") == 0) out ='.';
-  else if (strcmp(code,"--..--") == 0) out =',';
-  else if (strcmp(code,"-....-") == 0) out ='-';
-  else if (strcmp(code,"-...-") == 0)  out ='=';
-  else if (strcmp(code,"..--.-") == 0) out ='_';
-  else if (strcmp(code,"-..-.") == 0)  out ='/';
-  else if (strcmp(code,".-..-.") == 0) out ='\"';
-  else if (strcmp(code,"..--..") == 0) out ='?';
-  else if (strcmp(code,"-.-.--") == 0) out ='!';
-  else if (strcmp(code,".--.-.") == 0) out ='@';
-  else if (strcmp(code,"---...") == 0) out =':';
-  else if (strcmp(code,"-.-.-.") == 0) out =';';
-  else if (strcmp(code,"-.--.-") == 0) out =')';
-  else if (strcmp(code,"...-..-") == 0)out ='$';
- 
-  // Prosign codes
-  else if (strcmp(code,"-.--.") == 0)   out ='(';   // ( and KN - Over to you only
-  else if (strcmp(code,".-...") == 0)   out ='&';   // & and AS - Wait
-  else if (strcmp(code,".-.-.") == 0)   out ='+';   // + and AR - End of message
-  else if (strcmp(code,"-.-.-") == 0)   out ='}';   // KA - Starting signal
-  else if (strcmp(code,"...-.") == 0)   out ='~';   // SN - Understood
-  else if (strcmp(code,"...-.-") == 0)  out ='>';   // SK . End of contact
-  else if (strcmp(code,"-...-.-") == 0) out ='^';   // BK - Break
-  else if (strcmp(code,"-.-..-..") == 0)out ='{';   // CL - Closing station
-  else if (strcmp(code,"........") == 0)out = 0x7f; // Error / Correction
-  else if (strcmp(code,"...---...")== 0)out = '!';  // SOS
-
-  // This is a somewhat random collection of International Characters,
-  // including Icelandic, Norwegian/Danish, Swedish...
-  #if ICELAND_SYMBOLS
-  else if (strcmp(code,".--..") == 0)  out = 0;     // 'Þ'
-  else if (strcmp(code,"..--.") == 0)  out = 1;     // 'Ð'
-  #endif
-  #if ICELAND_SYMBOLS || NOR_DEN_SYMBOLS
-  else if (strcmp(code,".-.-") == 0)   out = 2;     // 'Æ' - overlaps with 'Ä'
-  #endif
-  #if SWEDEN_SYMBOLS
-  else if (strcmp(code,".-.-") == 0)   out = 6;     // 'Ä' - overlaps with 'Æ'
-  #endif
-  #if ICELAND_SYMBOLS || SWEDEN_SYMBOLS
-  else if (strcmp(code,"---.") == 0)   out = 3;     // 'Ö'  - overlaps with 'Ø'
-  #endif
-  #if NOR_DEN_SYMBOLS
-  else if (strcmp(code,"---.") == 0)   out = 4;     // 'Ø'  - overlaps with 'Ö'
-  #endif
-  #if NOR_DEN_SYMBOLS || SWEDEN_SYMBOLS
-  else if (strcmp(code,".--.-") == 0)  out = 5;     // 'Å'
-  #endif
-  #if REST_SYMBOLS
-  else if (strcmp(code,"..--") == 0)   out = 7;     // 'Ü'
-  else if (strcmp(code,"..-..") == 0)  out = 8;     // 'É'
-  else if (strcmp(code,"--.--") == 0)  out = 9;     // 'Ñ'
-  else if (strcmp(code,"----") == 0)   out = 10;    // 'Ch'
-  #endif
-  
-  else                                              // No code identified - error correction routine
-  {
-    out = 0xff;                                     // 0xff selected to indicate ERROR
-  }
-  return out;
+  if (code == MORSE_START) return "";
+
+  return morse_text(code);                          // NULL selected to indicate ERROR
 }
 
 
@@ -531,189 +432,17 @@ uint8_t CharacterIdFunc(void)
 // The Print Character Function prints to LCD and Serial (USB)
 //
 //------------------------------------------------------------------
-void PrintCharFunc(uint8_t c)
-{    
-#if 0
-  //--------------------------------------
-  // Print Characters to Serial (USB) port
-  //
-  // International (non ASCII characters) 
-  if (c == 0)      Serial.print("Þ");
-  else if (c == 1) Serial.print("Ð");
-  else if (c == 2) Serial.print("Æ");               // Same as Prosign AA
-  else if (c == 3) Serial.print("Ö");               // OE
-  else if (c == 4) Serial.print("Ø");               // Same as OE
-  else if (c == 5) Serial.print("Å");               // Could also be Á
-  else if (c == 6) Serial.print("Ä");               // Same as AE
-  else if (c == 7) Serial.print("Ü");
-  else if (c == 8) Serial.print("É");               // Could also be Á
-  else if (c == 9) Serial.print("Ñ");               // Same as AE
-  else if (c == 10) Serial.print("Ch");
-  
-  // Prosigns
-  else if (c == '}') Serial.print("ka");            // KA (starting signal)
-  else if (c == '(') Serial.print("kn");            // KN (over to you only)
-  else if (c == '&') Serial.print("as");            // AS (wait)
-  else if (c == '~') Serial.print("sn");            // SN (understood)
-  else if (c == '>') Serial.print("sk");            // SK (end of contact)
-  else if (c == '+') Serial.print("ar");            // AR (end of message)
-  else if (c == '^') Serial.print("bk");            // BK (break)
-  else if (c == '{') Serial.print("cl");            // CL (closing station)
-  else if (c == '!') Serial.print("sos");           // SOS
-  else if (c == 0x7f)Serial.print("err");           // Symbol for Error
-
-  else if (c == 0xff)Serial.print('#');             // Unresolved Error
-
-  // Normal Characters
-  else Serial.print((char) c);                      // Serial print ASCII character
-
-  //--------------------------------------
-  // Print Characters to LCD 
-  
-  //--------------------------------------
-  // International UTF-8 encoded (non ASCII) characters
-  #if ICELAND_SYMBOLS || NOR_DAN_SYMBOLS || SWEDEN_SYMBOLS || REST_SYMBOLS
-  char tmp[3];                                      // Accommodate UTF-8 encoded characters
-  if (c == 0) 
-  {
-    strcpy(tmp,"Þ");
-    lcdLineScrollPrint(tmp[0]);
-    lcdLineScrollPrint(tmp[1]);
-  }
-  else if (c == 1)
-  {
-    strcpy(tmp,"Ð");
-    lcdLineScrollPrint(tmp[0]);
-    lcdLineScrollPrint(tmp[1]);
-  }
-  else if (c == 2)
-  {
-    strcpy(tmp,"Æ");
-    lcdLineScrollPrint(tmp[0]);
-    lcdLineScrollPrint(tmp[1]);
-  }
-  else if (c == 3)
-  {
-    strcpy(tmp,"Ö");
-    lcdLineScrollPrint(tmp[0]);
-    lcdLineScrollPrint(tmp[1]);
-  }
-  else if (c == 4)
-  {
-    strcpy(tmp,"Ø");
-    lcdLineScrollPrint(tmp[0]);
-    lcdLineScrollPrint(tmp[1]);
-  }
-  else if (c == 5)
-  {
-    strcpy(tmp,"Å");
-    lcdLineScrollPrint(tmp[0]);
-    lcdLineScrollPrint(tmp[1]);
-  }
-  else if (c == 6)
-  {
-    strcpy(tmp,"Ä");
-    lcdLineScrollPrint(tmp[0]);
-    lcdLineScrollPrint(tmp[1]);
-  }
-  else if (c == 7)
+void PrintCharFunc(const char *text)
+{
+  // 0xff, a solid block on the 2x16 LCD, is our designated ERROR Symbol
+  if (!text)
   {
-    strcpy(tmp,"Ü");
-    lcdLineScrollPrint(tmp[0]);
-    lcdLineScrollPrint(tmp[1]);
+    morsePrint(0xff);
+    return;
   }
 
-  else if (c == 8)
-  {
-    strcpy(tmp,"É");
-    lcdLineScrollPrint(tmp[0]);
-    lcdLineScrollPrint(tmp[1]);
-  }
-  else if (c == 9)
-  {
-    strcpy(tmp,"Ñ");
-    lcdLineScrollPrint(tmp[0]);
-    lcdLineScrollPrint(tmp[1]);
-  }
-  else if (c == 10)
-  {
-    strcpy(tmp,"Ch");
-    lcdLineScrollPrint(tmp[0]);
-    lcdLineScrollPrint(tmp[1]);
-  }
-  #endif
-   
-  //--------------------------------------
-  // Prosigns
-  if (c == '}')
-  {
-    lcdLineScrollPrint('k');
-    lcdLineScrollPrint('a');   
-  }
-  else if (c == '(')
-  {
-    lcdLineScrollPrint('k');
-    lcdLineScrollPrint('n');   
-  }
-  else if (c == '&')
-  {
-    lcdLineScrollPrint('a');
-    lcdLineScrollPrint('s');   
-  }
-  else if (c == '~')
-  {
-    lcdLineScrollPrint('s');
-    lcdLineScrollPrint('n');   
-  }
-  else if (c == '>')
-  {
-    lcdLineScrollPrint('s');
-    lcdLineScrollPrint('k');   
-  }
-  else if (c == '+')
-  {
-    lcdLineScrollPrint('a');
-    lcdLineScrollPrint('r');   
-  }
-  else if (c == '^')
-  {
-    lcdLineScrollPrint('b');
-    lcdLineScrollPrint('k');   
-  }
-  else if (c == '{')
-  {
-    lcdLineScrollPrint('c');
-    lcdLineScrollPrint('l');   
-  }
-  else if (c == '!')
-  {
-    lcdLineScrollPrint('s');
-    lcdLineScrollPrint('o');   
-    lcdLineScrollPrint('s');   
-  }
-  else if (c == 0x7f)
-  {
-    lcdLineScrollPrint('e');
-    lcdLineScrollPrint('r');   
-    lcdLineScrollPrint('r');   
-  }
-  
-  //--------------------------------------
-  // # is our designated ERROR Symbol
-  else if (c == 0xff)
-  {
-    lcdLineScrollPrint('#');
-  }
-  
-  //--------------------------------------
-  // Normal Characters
-  else lcdLineScrollPrint(c);
-#else //if 0
-  //The acsii chars that map directly to the 2x16 LCD char set.
-  if( (c >= '!') && (c <= '}') ) morsePrint(c);
-  // The 'error' char
-  if( c == 0xff ) morsePrint(c);
-#endif
+  // Characters, and prosigns in lower case
+  while (*text) morsePrint(*text++);
 }
 
 
@@ -740,7 +469,6 @@ void WordSpaceFunc(uint8_t c)
       x = (cwspace_avg + pulse_avg) - w_space;      // (e.q. 4.15)
       if (x < 0)
       {
-        Serial.print(' ');
         morsePrint(' ');
         //lcdLineScrollPrint(' ');
       }
@@ -748,7 +476,6 @@ void WordSpaceFunc(uint8_t c)
     
     else
     {
-      Serial.print(' ');
       morsePrint(' ');
       //lcdLineScrollPrint(' ');
     }    
@@ -778,18 +505,16 @@ bool ErrorCorrectionFunc(void)
   int32_t  sduration;                 // Long symbol space duration and location
   int32_t  slocation;
   int32_t  temp_outcount;
-  uint8_t  decoded[]  = {0xff,0xff};
+  const char *decoded[] = {NULL, NULL};
   bool     result     = FALSE;        // Result of Error resolution - FALSE if nothing resolved
 
   uint64_t freezetime = millis();     // Guard against misbehaviour of DataRecognitionFunc()
   
   if (data_len >= DATA_BUFSIZE-2)     // Too long char received
   {
-    PrintCharFunc(0xff);              // Print Error to LCD and Serial (USB)
+    PrintCharFunc(NULL);              // Print Error to LCD and Serial (USB)
     WordSpaceFunc(0xff);              // Print Word Space to LCD and Serial when required
-    // Debug
-    Serial.println();
-    Serial.println("{{long_char}}");  
+    if (DEBUG) Serial.println("{{long_char}}");
   }
 
   else
@@ -873,12 +598,12 @@ bool ErrorCorrectionFunc(void)
       while((!DataRecognitionFunc()) && (millis() < freezetime+2));
       CodeGenFunc();                  // Generate a dot/dash pattern string
       decoded[0]=CharacterIdFunc();   // Convert dot/dash data into a character
-      if (decoded[0] != 0xff)
+      if (decoded[0])
       {
         PrintCharFunc(decoded[0]);
         result = TRUE;                // Error correction had success.
       }
-      else PrintCharFunc(0xff);
+      else PrintCharFunc(NULL);
     } 
 
     //-----------------------------------------------------
@@ -905,13 +630,13 @@ bool ErrorCorrectionFunc(void)
       CodeGenFunc();                  // Generate a dot/dash pattern string
       decoded[1]=CharacterIdFunc();   // Convert dot/dash pattern into a character
       
-      if ((decoded[0] != 0xff) && (decoded[1] != 0xff)) // If successful error resolution
+      if (decoded[0] && decoded[1])   // If successful error resolution
       {
         PrintCharFunc(decoded[0]);
         PrintCharFunc(decoded[1]);    
         result = TRUE;                // Error correction had success.
       }
-      else PrintCharFunc(0xff);
+      else PrintCharFunc(NULL);
     } 
   }
   return result;
@@ -923,8 +648,8 @@ uint32_t tf3lj_getWPM(void) {
   
   //-----------------------------------
   // Word time. Formula based on the word "PARIS"
-  spdcalc = 10.0*dot_avg + 4.0*dash_avg + 9.0*symspace_avg + 5.0*cwspace_avg;
-  spdcalc = spdcalc*1000.0/344.0;                 // Convert to Milliseconds per Word
-  spd = (0.5 + 60000.0 / spdcalc);                // Convert to Words per Minute (WPM)
+  spdcalc = 10.0f*dot_avg + 4.0f*dash_avg + 9.0f*symspace_avg + 5.0f*cwspace_avg;
+  spdcalc = spdcalc*1000.0f/344.0f;               // Convert to Milliseconds per Word
+  spd = (0.5f + 60000.0f / spdcalc);              // Convert to Words per Minute (WPM)
   return spd;
 }
@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Zoom FFT tuning aid - see tuning.h
+
+#include <Audio.h>
+#include <arm_math.h>
+#include <arm_const_structs.h>
+
+#include "global.h"
+#include "fir.h"
+#include "tuning.h"
+
+static float32_t rate;
+static float32_t centre;
+
+static float32_t lp_coeffs[TUNING_TAPS];
+static arm_fir_decimate_instance_f32 dec_i, dec_q;
+static float32_t dec_i_state[TUNING_TAPS + TUNING_MAX_BLOCK - 1];
+static float32_t dec_q_state[TUNING_TAPS + TUNING_MAX_BLOCK - 1];
+static float32_t mix_i[TUNING_MAX_BLOCK], mix_q[TUNING_MAX_BLOCK];
+static float32_t bb_i[TUNING_MAX_BLOCK / TUNING_DECIMATE], bb_q[TUNING_MAX_BLOCK / TUNING_DECIMATE];
+
+// Oscillator, as a rotating phasor
+static float32_t osc_re = 1.0, osc_im = 0.0;
+
+// Last TUNING_FFT_SIZE baseband samples
+static float32_t ring_i[TUNING_FFT_SIZE], ring_q[TUNING_FFT_SIZE];
+static int ring_pos = 0;
+static int since_fft = 0;
+
+static float32_t window[TUNING_FFT_SIZE];
+static float32_t fft_buf[TUNING_FFT_SIZE * 2];
+static float32_t power[TUNING_FFT_SIZE];
+
+static struct tuning_estimate estimate;
+
+void tuning_init(float32_t samplerate) {
+  rate = samplerate;
+  centre = morse_frequency;
+
+  // Pass up to about 80% of the new Nyquist
+  calc_FIR_coeffs(lp_coeffs, TUNING_TAPS, 0.4 * samplerate / TUNING_DECIMATE, 60.0, 0, 0.0, samplerate);
+  arm_fir_decimate_init_f32(&dec_i, TUNING_TAPS, TUNING_DECIMATE, lp_coeffs, dec_i_state, TUNING_MAX_BLOCK);
+  arm_fir_decimate_init_f32(&dec_q, TUNING_TAPS, TUNING_DECIMATE, lp_coeffs, dec_q_state, TUNING_MAX_BLOCK);
+
+  for (int i = 0; i < TUNING_FFT_SIZE; i++)
+    window[i] = 0.5 - 0.5 * cosf(2.0 * PI * i / TUNING_FFT_SIZE);
+
+  memset(&estimate, 0, sizeof(estimate));
+  tuning_reset();
+}
+
+void tuning_reset(void) {
+  memset(power, 0, sizeof(power));
+  memset(ring_i, 0, sizeof(ring_i));
+  memset(ring_q, 0, sizeof(ring_q));
+  since_fft = 0;
+}
+
+void tuning_set_centre(float32_t freq) {
+  centre = freq;
+}
+
+static void estimate_offset(void) {
+  const float32_t bin_hz = rate / TUNING_DECIMATE / TUNING_FFT_SIZE;
+  float32_t peak = 0.0, sum = 0.0, snr_db;
+  uint32_t pk;
+  int nsum = 0;
+
+  // Oldest sample first, windowed
+  for (int i = 0; i < TUNING_FFT_SIZE; i++) {
+    int j = (ring_pos + i) % TUNING_FFT_SIZE;
+    fft_buf[i * 2] = ring_i[j] * window[i];
+    fft_buf[i * 2 + 1] = ring_q[j] * window[i];
+  }
+  arm_cfft_f32(&arm_cfft_sR_f32_len64, fft_buf, 0, 1);
+
+  // Average the power, with the bins laid out -Nyquist to +Nyquist
+  for (int i = 0; i < TUNING_FFT_SIZE; i++) {
+    int k = (i + TUNING_FFT_SIZE / 2) % TUNING_FFT_SIZE;
+    float32_t p = fft_buf[k * 2] * fft_buf[k * 2] + fft_buf[k * 2 + 1] * fft_buf[k * 2 + 1];
+    power[i] = TUNING_AVERAGE * power[i] + (1.0 - TUNING_AVERAGE) * p;
+  }
+
+  // Ignore the outer bins - they are in the skirts of the low pass
+  arm_max_f32(&power[4], TUNING_FFT_SIZE - 8, &peak, &pk);
+  pk += 4;
+
+  // Noise is everything outside the main lobe of the peak
+  for (int i = 4; i < TUNING_FFT_SIZE - 4; i++) {
+    if (abs(i - (int)pk) <= 2) continue;
+    sum += power[i];
+    nsum++;
+  }
+  sum /= nsum;
+  if ((peak <= 0.0) || (sum <= 0.0)) return;
+
+  snr_db = 10.0 * log10f(peak / sum);
+
+  // Parabola through the peak and its neighbours, on a log scale
+  {
+    float32_t a = logf(power[pk - 1] + 1e-20);
+    float32_t b = logf(power[pk] + 1e-20);
+    float32_t c = logf(power[pk + 1] + 1e-20);
+    float32_t d = a - 2.0 * b + c;
+    float32_t delta = (d < 0.0) ? 0.5 * (a - c) / d : 0.0;
+
+    estimate.offset = ((float32_t)pk - TUNING_FFT_SIZE / 2 + delta) * bin_hz;
+    estimate.freq = centre + estimate.offset;
+  }
+
+  estimate.confidence = (snr_db - TUNING_SNR_MIN_DB) / (TUNING_SNR_FULL_DB - TUNING_SNR_MIN_DB);
+  if (estimate.confidence < 0.0) estimate.confidence = 0.0;
+  if (estimate.confidence > 1.0) estimate.confidence = 1.0;
+  estimate.version++;
+}
+
+void tuning_process(const float32_t *buf, uint32_t n) {
+  const float32_t w = 2.0 * PI * centre / rate;
+  const float32_t step_re = cosf(w), step_im = -sinf(w);
+  float32_t re = osc_re, im = osc_im, mag;
+  uint32_t nout;
+
+  if (n > TUNING_MAX_BLOCK) n = TUNING_MAX_BLOCK;
+  nout = n / TUNING_DECIMATE;
+
+  // Mix down, so the pitch lands at 0 Hz
+  for (uint32_t i = 0; i < n; i++) {
+    float32_t t;
+
+    mix_i[i] = buf[i] * re;
+    mix_q[i] = buf[i] * im;
+
+    t = re * step_re - im * step_im;
+    im = re * step_im + im * step_re;
+    re = t;
+  }
+
+  // Pull the phasor back onto the unit circle, so it does not drift off
+  mag = 1.0 / sqrtf(re * re + im * im);
+  osc_re = re * mag;
+  osc_im = im * mag;
+
+  arm_fir_decimate_f32(&dec_i, mix_i, bb_i, n);
+  arm_fir_decimate_f32(&dec_q, mix_q, bb_q, n);
+
+  for (uint32_t i = 0; i < nout; i++) {
+    ring_i[ring_pos] = bb_i[i];
+    ring_q[ring_pos] = bb_q[i];
+    if (++ring_pos >= TUNING_FFT_SIZE) ring_pos = 0;
+
+    if (++since_fft >= TUNING_HOP) {
+      since_fft = 0;
+      estimate_offset();
+    }
+  }
+}
+
+bool tuning_read(struct tuning_estimate *e) {
+  if (estimate.version == 0) return false;
+  *e = estimate;
+  return true;
+}
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GNU General Public License v3.0 or later
+
+// Zoom FFT tuning aid.
+//
+// Mix the decimated audio down by the centre frequency (morse_frequency,
+// unless the pitch tracker has moved us), low pass and decimate it
+// again to a narrow complex baseband, and FFT that. We get about 11 Hz bins
+// over +/- 340 Hz either side of the pitch, and an interpolated peak gets us
+// to a Hz or two. The power spectra are averaged, so the estimate does not
+// jump about on a noisy signal, and how far the peak stands out of the
+// average gives us a confidence.
+
+#ifndef TUNING_H
+#define TUNING_H
+
+#include <arm_math.h>
+
+#define TUNING_DECIMATE   16
+#define TUNING_TAPS       64
+#define TUNING_FFT_SIZE   64
+#define TUNING_HOP        (TUNING_FFT_SIZE / 2)
+
+// Largest block we get handed, in decimated samples
+#define TUNING_MAX_BLOCK  256
+
+// Weight of the old power spectrum against the new one
+#define TUNING_AVERAGE    0.6
+
+// SNR of the peak over the rest, in dB, for a confidence of 0 and of 1
+#define TUNING_SNR_MIN_DB   6.0
+#define TUNING_SNR_FULL_DB  26.0
+
+// Confidence we want before we move the LCD arrows
+#define TUNING_MIN_CONFIDENCE 0.3
+
+struct tuning_estimate {
+  float32_t freq;         // Hz, where we think the signal is
+  float32_t offset;       // Hz, signal - centre
+  float32_t confidence;   // 0 to 1
+  uint32_t version;       // Bumped on every new estimate
+};
+
+extern void tuning_init(float32_t samplerate);
+
+// n decimated samples, a multiple of TUNING_DECIMATE
+extern void tuning_process(const float32_t *buf, uint32_t n);
+
+// Latest estimate. Returns false if we do not have one yet.
+extern bool tuning_read(struct tuning_estimate *e);
+
+// Move where we zoom in.
+extern void tuning_set_centre(float32_t freq);
+
+// Forget the averaged spectrum - after a big move of the centre.
+extern void tuning_reset(void);
+
+#endif
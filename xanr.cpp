@@ -6,14 +6,15 @@
 #include <arm_const_structs.h>
 
 #include "global.h"
+#include "xanr.h"
 
 
 // Automatic noise reduction
 // Variable-leak LMS algorithm
 // taken from (c) Warren Pratts wdsp library 2016
 // GPLv3 licensed
-#define ANR_DLINE_SIZE 512 //funktioniert nicht, 128 & 256 OK                 // dline_size
 int ANR_taps =     64; //64;                       // taps
+int ANR_taps_max = ANR_DLINE_SIZE;                  // cap on the taps, if we are short of CPU
 int ANR_delay =    32; //16;                       // delay // Graham - 32 seems to reduce noise more.
 int ANR_dline_size = ANR_DLINE_SIZE;
 int ANR_buff_size = FFT_length / 2.0;
@@ -59,6 +60,7 @@ void xanr (bool notch) // variable leak LMS algorithm for automatic notch or noi
   float32_t nel, nev;
   float32_t *ANR_d, *ANR_w;
   int ANR_in_idx;
+  int taps = (ANR_taps < ANR_taps_max) ? ANR_taps : ANR_taps_max;
 
   //Separate history buffers for notch and nr, so we can run both at once.
   if (notch) {
@@ -78,7 +80,7 @@ void xanr (bool notch) // variable leak LMS algorithm for automatic notch or noi
     y = 0;
     sigma = 0;
 
-    for (int j = 0; j < ANR_taps; j++)
+    for (int j = 0; j < taps; j++)
     {
       idx = (ANR_in_idx + j + ANR_delay) & ANR_mask;
       y += ANR_w[j] * ANR_d[idx];
@@ -102,7 +104,7 @@ void xanr (bool notch) // variable leak LMS algorithm for automatic notch or noi
     c0 = 1.0 - ANR_two_mu * ANR_ngamma;
     c1 = ANR_two_mu * error * inv_sigp;
 
-    for (int j = 0; j < ANR_taps; j++)
+    for (int j = 0; j < taps; j++)
     {
       idx = (ANR_in_idx + j + ANR_delay) & ANR_mask;
       ANR_w[j] = c0 * ANR_w[j] + c1 * ANR_d[idx];
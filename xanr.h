@@ -1,10 +1,13 @@
 
 #include <arm_math.h>
 
+#define ANR_DLINE_SIZE 512 //funktioniert nicht, 128 & 256 OK                 // dline_size
+
 extern void xanr_init ();
 extern void xanr (bool notch);
 
 extern int ANR_taps;
+extern int ANR_taps_max;
 extern int ANR_delay;
 extern float32_t ANR_two_mu;
 extern float32_t ANR_gamma;